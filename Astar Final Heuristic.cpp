@@ -3,20 +3,100 @@
 #include <queue>
 #include <unordered_map>
 #include <vector>
+#include <cstring>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <new>
+#include <sstream>
 #include <sys/time.h>
 
 using namespace std;
 
-// The size of the puzzle board
+// The size of the puzzle board: 3 for the 8-puzzle, 4 for the 15-puzzle, ...
+#ifndef BOARD_SIZE
 #define BOARD_SIZE 3
+#endif
+
+// The closed list: 0 = flat table indexed by permutation rank,
+// 1 = the node-hashed unordered_map (kept so the two can be A/B'd)
+// Only the 8-puzzle is small enough to rank, bigger boards always hash
+#if BOARD_SIZE != 3
+#undef CLOSED_HASH_TABLE
+#define CLOSED_HASH_TABLE 1
+#endif
+#ifndef CLOSED_HASH_TABLE
+#define CLOSED_HASH_TABLE 0
+#endif
+
+// The open list: 1 = buckets indexed by (f, g), 0 = binary heap on f
+#ifndef OPEN_LIST_BUCKETS
+#define OPEN_LIST_BUCKETS 1
+#endif
+
+// Among equal f values the bucket open list pops: 1 = deepest node first, 0 = shallowest
+#ifndef PREFER_HIGH_G
+#define PREFER_HIGH_G 1
+#endif
+
+// A cheaper path to an already expanded node: 1 = move the node back to OPEN at its new
+// cost (reopening), 0 = ignore it, which is only safe when the heuristic is consistent.
+// numOutPlace() counts the blank, so it can drop by 2 in one move and is not consistent
+#ifndef REOPEN_CLOSED
+#define REOPEN_CLOSED 1
+#endif
+
+// What main() reports for each search: 0 = nothing, 1 = the solution path,
+// 2 = one CSV line, 3 = one JSON line, 4 = the full report with its statistics
+#ifndef OUTPUT_MODE
+#define OUTPUT_MODE 4
+#endif
+
+// 1 = print every node as it is expanded, which makes terminal I/O the bulk of the run time
+#ifndef TRACE_EXPANSIONS
+#define TRACE_EXPANSIONS 0
+#endif
+
+// The number of boards reachable from any one start (9!/2)
+#define NUM_STATES 181440
 
 // The goal state of the puzzle
-int goal_state[BOARD_SIZE][BOARD_SIZE] = {
-    {1, 2, 3},
-    {8, 0, 4},
-    {7, 6, 5}
+// The tiles run clockwise round the board from the top left corner, spiralling inwards,
+// and the blank sits on the last cell reached:
+//     1 2 3
+//     8 0 4
+//     7 6 5
+struct GoalBoard {
+    int board[BOARD_SIZE][BOARD_SIZE];
+
+    GoalBoard() {
+        int top = 0, bottom = BOARD_SIZE - 1, left = 0, right = BOARD_SIZE - 1;
+        int tile = 1;
+        memset(board, 0, sizeof(board));
+        while (tile < BOARD_SIZE * BOARD_SIZE) {
+            for (int column = left; column <= right && tile < BOARD_SIZE * BOARD_SIZE; column++) {
+                board[top][column] = tile++;
+            }
+            top++;
+            for (int row = top; row <= bottom && tile < BOARD_SIZE * BOARD_SIZE; row++) {
+                board[row][right] = tile++;
+            }
+            right--;
+            for (int column = right; column >= left && tile < BOARD_SIZE * BOARD_SIZE; column--) {
+                board[bottom][column] = tile++;
+            }
+            bottom--;
+            for (int row = bottom; row >= top && tile < BOARD_SIZE * BOARD_SIZE; row--) {
+                board[row][left] = tile++;
+            }
+            left++;
+        }
+    }
 };
 
+const GoalBoard goal_board;
+const int (&goal_state)[BOARD_SIZE][BOARD_SIZE] = goal_board.board;
+
 int numOutPlace(int b[BOARD_SIZE][BOARD_SIZE]) {
     int outPlace = 0;
     for(int row=0; row < BOARD_SIZE; row++) {
@@ -29,12 +109,36 @@ int numOutPlace(int b[BOARD_SIZE][BOARD_SIZE]) {
     return outPlace;
 }
 
+// Whether each value (0 for the blank) is out of place on each cell, [value][row * BOARD_SIZE + column]
+struct OutPlaceTable {
+    int misplaced[BOARD_SIZE * BOARD_SIZE][BOARD_SIZE * BOARD_SIZE];
+
+    OutPlaceTable() {
+        for (int value = 0; value < BOARD_SIZE * BOARD_SIZE; value++) {
+            for (int cell = 0; cell < BOARD_SIZE * BOARD_SIZE; cell++) {
+                misplaced[value][cell] = goal_state[cell / BOARD_SIZE][cell % BOARD_SIZE] != value;
+            }
+        }
+    }
+};
+
+const OutPlaceTable out_place_table;
+
+// numOutPlace() of a child board, from its parent's value, after tile swapped places
+// with the blank: the blank moved from blank_cell to tile_cell and the tile the other way
+int moveOutPlace(int parent_h, int tile, int blank_cell, int tile_cell) {
+    const int (&misplaced)[BOARD_SIZE * BOARD_SIZE][BOARD_SIZE * BOARD_SIZE] = out_place_table.misplaced;
+    return parent_h
+        - misplaced[0][blank_cell] - misplaced[tile][tile_cell]
+        + misplaced[0][tile_cell] + misplaced[tile][blank_cell];
+}
+
 // The node of the puzzle board
 struct Node {
     int board[BOARD_SIZE][BOARD_SIZE]; // The current state of the board
     int g, h, f; // The values used by A* FINAL algorithm
     Node* parent; // The parent node
-    vector<Node*> successors; // The children
+    int open_slot; // The position in the open list's heap or bucket, -1 when not on OPEN
 
     Node(int b[BOARD_SIZE][BOARD_SIZE], int g_, int h_, Node* parent_) {
         for (int i = 0; i < BOARD_SIZE; i++) {
@@ -46,6 +150,7 @@ struct Node {
         h = h_;
         f = g + h;
         parent = parent_;
+        open_slot = -1;
     }
 
     bool operator==(const Node& other) const {
@@ -60,6 +165,42 @@ struct Node {
     }
 };
 
+// Arena for the nodes of one search
+// Nodes are carved out of fixed-size chunks, so they never move and are never freed one
+// by one; reset() releases a whole search at once and keeps the chunks for the next one
+class NodePool {
+public:
+    NodePool() : used(0) {}
+    ~NodePool() {
+        reset();
+        for (Node* chunk : chunks) {
+            operator delete(chunk);
+        }
+    }
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    Node* create(int b[BOARD_SIZE][BOARD_SIZE], int g, int h, Node* parent) {
+        if (used == chunks.size() * CHUNK_SIZE) {
+            chunks.push_back(static_cast<Node*>(operator new(CHUNK_SIZE * sizeof(Node))));
+        }
+        Node* n = chunks[used / CHUNK_SIZE] + used % CHUNK_SIZE;
+        used++;
+        return new (n) Node(b, g, h, parent);
+    }
+    // Destroy every node handed out since the last reset
+    void reset() {
+        for (size_t i = 0; i < used; i++) {
+            chunks[i / CHUNK_SIZE][i % CHUNK_SIZE].~Node();
+        }
+        used = 0;
+    }
+private:
+    static const size_t CHUNK_SIZE = 4096;
+    vector<Node*> chunks;
+    size_t used;
+};
+
 // The hash function for the unordered_map
 struct NodeHash {
     size_t operator()(const Node* n) const {
@@ -73,6 +214,80 @@ struct NodeHash {
     }
 };
 
+// Board equality for the unordered_map, so lookups match on the board rather than the pointer
+struct NodeEqual {
+    bool operator()(const Node* n1, const Node* n2) const {
+        return *n1 == *n2;
+    }
+};
+
+// Perfect hash of a board onto [0, NUM_STATES)
+// The tiles read in row order (blank skipped) keep their parity under every move on an
+// odd-width board, so half the Lehmer-code rank of that order is unique among reachable
+// boards; the blank's cell picks the block
+int boardRank(int b[BOARD_SIZE][BOARD_SIZE]) {
+    int rank = 0;
+    int remaining = BOARD_SIZE * BOARD_SIZE - 1;
+    int blank = 0;
+    unsigned seen = 0;
+    for(int row=0; row < BOARD_SIZE; row++) {
+        for(int column=0; column < BOARD_SIZE; column++) {
+            int tile = b[row][column];
+            if(tile == 0) {
+                blank = row * BOARD_SIZE + column;
+                continue;
+            }
+            int smaller_unseen = tile - 1 - __builtin_popcount(seen & ((1u << tile) - 1));
+            rank = rank * remaining-- + smaller_unseen;
+            seen |= 1u << tile;
+        }
+    }
+    return blank * (NUM_STATES / (BOARD_SIZE * BOARD_SIZE)) + rank / 2;
+}
+
+// Lookup from a board to the node holding it, on OPEN (open_slot >= 0) or CLOSED alike
+// Like NodePool it lives across searches: reset() forgets one search's boards, and the
+// rank table clears only the slots that search filled rather than all NUM_STATES of them
+class BoardIndex {
+public:
+#if CLOSED_HASH_TABLE
+    Node* find(int b[BOARD_SIZE][BOARD_SIZE]) const {
+        Node probe(b, 0, 0, nullptr);
+        auto it = nodes.find(&probe);
+        return it == nodes.end() ? nullptr : it->second;
+    }
+    void insert(Node* n) {
+        nodes[n] = n;
+    }
+    void reset() {
+        nodes.clear();
+    }
+private:
+    unordered_map<Node*, Node*, NodeHash, NodeEqual> nodes;
+#else
+    BoardIndex() : nodes(NUM_STATES, nullptr) {}
+    Node* find(int b[BOARD_SIZE][BOARD_SIZE]) const {
+        return nodes[boardRank(b)];
+    }
+    void insert(Node* n) {
+        int rank = boardRank(n->board);
+        if (nodes[rank] == nullptr) {
+            filled.push_back(rank);
+        }
+        nodes[rank] = n;
+    }
+    void reset() {
+        for (int rank : filled) {
+            nodes[rank] = nullptr;
+        }
+        filled.clear();
+    }
+private:
+    vector<Node*> nodes; // One slot per reachable board, indexed by boardRank()
+    vector<int> filled; // The slots set since the last reset()
+#endif
+};
+
 // The comparator function for the priority queue
 struct NodeCompare {
     bool operator()(const Node* n1, const Node* n2) const {
@@ -80,6 +295,208 @@ struct NodeCompare {
     }
 };
 
+// Open list as a binary heap on f
+// Each node remembers its heap slot, so a node found through the BoardIndex can have its
+// f lowered in place instead of draining and refilling the queue
+class HeapOpenList {
+public:
+    bool empty() const {
+        return heap.empty();
+    }
+    size_t size() const {
+        return heap.size();
+    }
+    void push(Node* n) {
+        n->open_slot = heap.size();
+        heap.push_back(n);
+        siftUp(n->open_slot);
+    }
+    // Remove and return the node with the lowest f value
+    Node* pop() {
+        Node* top = heap.front();
+        place(heap.back(), 0);
+        heap.pop_back();
+        if (!heap.empty()) {
+            siftDown(0);
+        }
+        top->open_slot = -1;
+        return top;
+    }
+    // Lower the g (and f) value of a node on OPEN
+    void decreaseKey(Node* n, int g) {
+        n->g = g;
+        n->f = n->g + n->h;
+        siftUp(n->open_slot);
+    }
+private:
+    vector<Node*> heap;
+    NodeCompare greater;
+
+    void place(Node* n, int i) {
+        heap[i] = n;
+        n->open_slot = i;
+    }
+    void siftUp(int i) {
+        Node* n = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!greater(heap[parent], n)) {
+                break;
+            }
+            place(heap[parent], i);
+            i = parent;
+        }
+        place(n, i);
+    }
+    void siftDown(int i) {
+        Node* n = heap[i];
+        int count = heap.size();
+        while (2 * i + 1 < count) {
+            int child = 2 * i + 1;
+            if (child + 1 < count && greater(heap[child], heap[child + 1])) {
+                child++;
+            }
+            if (!greater(n, heap[child])) {
+                break;
+            }
+            place(heap[child], i);
+            i = child;
+        }
+        place(n, i);
+    }
+};
+
+// Open list as one bucket per (f, g) pair
+// f and g are small integers, so push, pop and decrease-key are all O(1); among equal f
+// the deepest (or shallowest) nodes come out first, most recently pushed first
+class BucketOpenList {
+public:
+    BucketOpenList() : min_f(0), count(0) {}
+    bool empty() const {
+        return count == 0;
+    }
+    size_t size() const {
+        return count;
+    }
+    void push(Node* n) {
+        add(n);
+    }
+    // Remove and return a node with the lowest f value
+    Node* pop() {
+        while (f_counts[min_f] == 0) {
+            min_f++;
+        }
+        vector<vector<Node*>>& by_g = buckets[min_f];
+        int g;
+        if (PREFER_HIGH_G) {
+            g = by_g.size() - 1;
+            while (by_g[g].empty()) {
+                g--;
+            }
+        }
+        else {
+            g = 0;
+            while (by_g[g].empty()) {
+                g++;
+            }
+        }
+        Node* top = by_g[g].back();
+        remove(top);
+        return top;
+    }
+    // Lower the g (and f) value of a node on OPEN by moving it to its new bucket
+    void decreaseKey(Node* n, int g) {
+        remove(n);
+        n->g = g;
+        n->f = n->g + n->h;
+        add(n);
+    }
+private:
+    vector<vector<vector<Node*>>> buckets; // [f][g]
+    vector<int> f_counts; // The number of nodes with each f value
+    int min_f; // No node on OPEN has a lower f value
+    size_t count;
+
+    void add(Node* n) {
+        if (n->f >= (int)buckets.size()) {
+            buckets.resize(n->f + 1);
+            f_counts.resize(n->f + 1, 0);
+        }
+        vector<vector<Node*>>& by_g = buckets[n->f];
+        if (n->g >= (int)by_g.size()) {
+            by_g.resize(n->g + 1);
+        }
+        n->open_slot = by_g[n->g].size();
+        by_g[n->g].push_back(n);
+        f_counts[n->f]++;
+        count++;
+        if (count == 1 || n->f < min_f) {
+            min_f = n->f;
+        }
+    }
+    void remove(Node* n) {
+        vector<Node*>& bucket = buckets[n->f][n->g];
+        Node* last = bucket.back();
+        bucket[n->open_slot] = last;
+        last->open_slot = n->open_slot;
+        bucket.pop_back();
+        n->open_slot = -1;
+        f_counts[n->f]--;
+        count--;
+    }
+};
+
+#if OPEN_LIST_BUCKETS
+typedef BucketOpenList OpenList;
+#else
+typedef HeapOpenList OpenList;
+#endif
+
+// Whether b holds every value from 0 to BOARD_SIZE * BOARD_SIZE - 1 exactly once
+bool isValidBoard(int b[BOARD_SIZE][BOARD_SIZE]) {
+    bool seen[BOARD_SIZE * BOARD_SIZE] = {false};
+    for(int row=0; row < BOARD_SIZE; row++) {
+        for(int column=0; column < BOARD_SIZE; column++) {
+            int value = b[row][column];
+            if(value < 0 || value >= BOARD_SIZE * BOARD_SIZE || seen[value]) {
+                return false;
+            }
+            seen[value] = true;
+        }
+    }
+    return true;
+}
+
+// Whether the goal can be reached from b
+// Every move swaps the blank with a tile, which flips both the parity of the permutation
+// taking the goal onto b and the parity of the blank's distance from its goal cell, so
+// the goal is reachable exactly when the two agree; the permutation's parity comes from
+// counting its cycles in one pass over the cells
+bool isSolvable(int b[BOARD_SIZE][BOARD_SIZE]) {
+    int goal_cell[BOARD_SIZE * BOARD_SIZE];
+    for(int cell=0; cell < BOARD_SIZE * BOARD_SIZE; cell++) {
+        goal_cell[goal_state[cell / BOARD_SIZE][cell % BOARD_SIZE]] = cell;
+    }
+    bool visited[BOARD_SIZE * BOARD_SIZE] = {false};
+    int cycles = 0;
+    int blank_cell = 0;
+    for(int start=0; start < BOARD_SIZE * BOARD_SIZE; start++) {
+        if(b[start / BOARD_SIZE][start % BOARD_SIZE] == 0) {
+            blank_cell = start;
+        }
+        if(visited[start]) {
+            continue;
+        }
+        cycles++;
+        for(int cell = start; !visited[cell]; cell = goal_cell[b[cell / BOARD_SIZE][cell % BOARD_SIZE]]) {
+            visited[cell] = true;
+        }
+    }
+    int blank_distance = abs(blank_cell / BOARD_SIZE - goal_cell[0] / BOARD_SIZE)
+                       + abs(blank_cell % BOARD_SIZE - goal_cell[0] % BOARD_SIZE);
+    return (BOARD_SIZE * BOARD_SIZE - cycles) % 2 == blank_distance % 2;
+}
+
 // Find the location of 0
 vector<int> zeroLocation(int b[BOARD_SIZE][BOARD_SIZE]) {
     for(int row=0; row < BOARD_SIZE; row++) {
@@ -93,78 +510,260 @@ vector<int> zeroLocation(int b[BOARD_SIZE][BOARD_SIZE]) {
 }
 
 
-double getCost(Node* start_node, Node* end_node) {
-    // Compute the cost of the path between the start and end nodes
-    double cost = 0.0;
-    Node* current_node = end_node;
-    while (current_node != start_node) {
-        cost += current_node->g - current_node->parent->g;
-        current_node = current_node->parent;
+void boardOutput(const int b[BOARD_SIZE][BOARD_SIZE], ostream& out) {
+    // Tiles past 9 take two columns, so every cell gets the same width
+    int width = BOARD_SIZE * BOARD_SIZE > 10 ? 2 : 1;
+    string rule = " " + string(BOARD_SIZE * (width + 3) + 1, '-');
+    out << rule << '\n';
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        out << " |";
+        for (int column = 0; column < BOARD_SIZE; column++) {
+            out << " " << setw(width) << b[row][column] << " |";
+        }
+        out << '\n';
+        out << rule << '\n';
     }
-    return cost;
 }
 
-// DFS through recursion to update node within closed
-void propagateImprovement(Node* node) {
-    for (Node* successor : node->successors) {
-        // If the successor's parent is the current node, continue propagation
-        if (successor->parent == node) {
-            // Calculate the new g value for the successor
-            double new_g = node->g + getCost(node, successor);
-            // If the new g value is better than the current g value, update the parent and g values
-            if (new_g < successor->g) {
-                successor->parent = node;
-                successor->g = new_g;
-                // Recursively propagate improvement to the successor's descendants
-                propagateImprovement(successor);
-            }
+// How a search ended and what it cost
+// goal_node is the goal's node with its parent chain, so it lives in the search's pool and
+// stays readable until that pool is next reset
+struct SearchResult {
+    enum Outcome { INVALID, UNSOLVABLE, NOT_FOUND, FOUND } outcome;
+    Node* goal_node;
+    int nodes_generated; // Every node put on OPEN, counting the start and cheaper paths found
+    int nodes_expanded;  // Every node taken off OPEN
+    int depth;
+    long elapsed_time; // Microseconds spent searching, output excluded
+};
+
+// The effective branching factor b*: the branching of a uniform tree of depth d with N
+// nodes below its root, N = b* + b*^2 + ... + b*^d, found by bisection on b*
+double effectiveBranchFactor(int N, int d) {
+    if (d <= 0 || N <= 0) {
+        return 0;
+    }
+    double low = 0, high = N > 1 ? N : 1;
+    for (int i = 0; i < 100; i++) {
+        double b = (low + high) / 2, power = 1, total = 0;
+        for (int level = 0; level < d && total <= N; level++) {
+            power *= b;
+            total += power;
+        }
+        if (total < N) {
+            low = b;
+        }
+        else {
+            high = b;
         }
     }
+    return (low + high) / 2;
 }
 
-void boardOutput(int b[BOARD_SIZE][BOARD_SIZE]) {
-    cout << " -------------" << endl;
-    cout << " | " << b[0][0] << " | " << b[0][1] << " | " << b[0][2] << " | " <<  endl;
-    cout << " -------------" << endl;
-    cout << " | " << b[1][0] << " | " << b[1][1] << " | " << b[1][2] << " | " << endl;
-    cout << " -------------" << endl;
-    cout << " | " << b[2][0] << " | " << b[2][1] << " | " << b[2][2] << " | " << endl;
-    cout << " -------------" << endl;
+// Writes search results in one of the OUTPUT_MODE formats
+// Everything goes to an in-memory buffer that reaches the stream only when it grows past
+// FLUSH_SIZE or on flush(), so a run of searches never waits on the terminal in between
+class ResultSink {
+public:
+    enum Mode { SILENT, PATH, CSV, JSON, REPORT };
+
+    ResultSink(ostream& out_, Mode mode_) : out(out_), mode(mode_), written(0) {}
+    ~ResultSink() {
+        flush();
+    }
+    ResultSink(const ResultSink&) = delete;
+    ResultSink& operator=(const ResultSink&) = delete;
+
+    void write(int initial_state[BOARD_SIZE][BOARD_SIZE], const SearchResult& result) {
+        switch (mode) {
+        case SILENT:
+            break;
+        case PATH:
+            writePath(result);
+            break;
+        case CSV:
+            if (written == 0) {
+                buffer << "outcome,moves,nodes_generated,nodes_expanded,microseconds\n";
+            }
+            buffer << outcomeName(result.outcome) << ',' << result.depth << ',' << result.nodes_generated
+                   << ',' << result.nodes_expanded << ',' << result.elapsed_time << '\n';
+            break;
+        case JSON:
+            buffer << "{\"outcome\":\"" << outcomeName(result.outcome) << "\",\"moves\":" << result.depth
+                   << ",\"nodes_generated\":" << result.nodes_generated
+                   << ",\"nodes_expanded\":" << result.nodes_expanded
+                   << ",\"microseconds\":" << result.elapsed_time << "}\n";
+            break;
+        case REPORT:
+            writeReport(initial_state, result);
+            break;
+        }
+        written++;
+        if (buffer.tellp() > FLUSH_SIZE) {
+            flush();
+        }
+    }
+    void flush() {
+        out << buffer.str();
+        out.flush();
+        buffer.str("");
+    }
+private:
+    static const int FLUSH_SIZE = 1 << 16;
+    ostream& out;
+    Mode mode;
+    ostringstream buffer;
+    size_t written;
+
+    static const char* outcomeName(SearchResult::Outcome outcome) {
+        switch (outcome) {
+        case SearchResult::INVALID:
+            return "invalid";
+        case SearchResult::UNSOLVABLE:
+            return "unsolvable";
+        case SearchResult::NOT_FOUND:
+            return "not_found";
+        default:
+            return "found";
+        }
+    }
+    // The boards from the start to the goal, one after another
+    void writePath(const SearchResult& result) {
+        if (result.outcome != SearchResult::FOUND) {
+            buffer << outcomeName(result.outcome) << '\n';
+            return;
+        }
+        vector<Node*> path;
+        for (Node* n = result.goal_node; n != nullptr; n = n->parent) {
+            path.push_back(n);
+        }
+        for (size_t i = path.size(); i-- > 0;) {
+            boardOutput(path[i]->board, buffer);
+            buffer << '\n';
+        }
+    }
+    void writeReport(int initial_state[BOARD_SIZE][BOARD_SIZE], const SearchResult& result) {
+        buffer << "START BOARD" << '\n';
+        if (result.outcome == SearchResult::INVALID) {
+            buffer << "INVALID BOARD" << '\n';
+            return;
+        }
+        boardOutput(initial_state, buffer);
+        if (result.outcome == SearchResult::UNSOLVABLE) {
+            buffer << "NO SOLUTION: the goal cannot be reached from this board" << '\n';
+            return;
+        }
+        if (result.outcome == SearchResult::NOT_FOUND) {
+            buffer << "NO SOLUTION FOUND" << '\n';
+            return;
+        }
+        buffer << "GOAL FOUND ^^" << '\n';
+        int NG = result.nodes_generated;
+        buffer << "Nodes Generated = " << NG << '\n';
+        int NE = result.nodes_expanded;
+        buffer << "Nodes Expanded = " << NE << '\n';
+        int D = result.depth;
+        buffer << "Depth of Tree = " << D << '\n';
+        double b_star = effectiveBranchFactor(NG - 1, D);
+        buffer << "Effective Branch Factor = " << b_star << '\n';
+        int TP = D + 1;
+        buffer << "Total Path = " << TP << '\n';
+        buffer << "Elapsed Time = " << result.elapsed_time << " micro-seconds" << '\n';
+    }
+};
+
+// Merge a child board of BESTNODE into the OPEN and CLOSED lists
+// Every board the search has seen is in index, on OPEN if its open_slot is set and on
+// CLOSED otherwise; h is the child's numOutPlace() value; generated counts the child if
+// it was new or reached more cheaply than before
+void generateChild(Node* best_node, int new_board[BOARD_SIZE][BOARD_SIZE], int h, OpenList& open, BoardIndex& index, NodePool& pool, int& generated) {
+    int g = best_node->g + 1;
+    Node* old_node = index.find(new_board);
+    if (old_node == nullptr) {
+        Node* new_node = pool.create(new_board, g, h, best_node);
+        open.push(new_node);
+        index.insert(new_node);
+        generated++;
+    }
+    else if (old_node->open_slot >= 0) {
+        if (g < old_node->g) {
+            // Found a cheaper path to an already generated node on OPEN
+            // Reset its parent link to point to BESTNODE
+            old_node->parent = best_node;
+            // We changed the cost of the node, move it up the queue
+            open.decreaseKey(old_node, g);
+            generated++;
+        }
+    }
+#if REOPEN_CLOSED
+    else if (g < old_node->g) {
+        // Found a cheaper path to an already explored node on CLOSED
+        // Reopen it: it goes back on OPEN at the new cost and its successors are
+        // regenerated from there when it is expanded again, so nothing is walked now
+        old_node->parent = best_node;
+        old_node->g = g;
+        old_node->f = g + old_node->h;
+        open.push(old_node);
+        generated++;
+    }
+#endif
 }
 
 // The A* FINAL algorithm function
-void AStar(int initial_state[BOARD_SIZE][BOARD_SIZE]) {
-    // The open and closed lists
-    priority_queue<Node*, vector<Node*>, NodeCompare> open;
-    unordered_map<Node*, bool, NodeHash> closed;
+// The nodes live in pool and the board lookup in index, both reset first, so one pair can
+// serve many searches; the search itself prints nothing (unless TRACE_EXPANSIONS), the
+// caller hands the result to a sink
+SearchResult AStar(int initial_state[BOARD_SIZE][BOARD_SIZE], NodePool& pool, BoardIndex& index) {
+    pool.reset();
+    index.reset();
+    SearchResult result = {SearchResult::NOT_FOUND, nullptr, 0, 0, 0, 0};
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+
+    // Turn away boards the search could never finish on before building anything
+    if (!isValidBoard(initial_state)) {
+        result.outcome = SearchResult::INVALID;
+        return result;
+    }
+    if (!isSolvable(initial_state)) {
+        result.outcome = SearchResult::UNSOLVABLE;
+        return result;
+    }
+
+    // The open list; the closed list is every node in index that is not on it
+    OpenList open;
 
     int depth = 0;
     // The initial node
     int h = numOutPlace(initial_state);
-    Node* initial_node = new Node(initial_state, 0, h, nullptr);
+    Node* initial_node = pool.create(initial_state, 0, h, nullptr);
 
     // Add the initial node to the open list
     open.push(initial_node);
+    index.insert(initial_node);
+    result.nodes_generated = 1;
 
     while (!open.empty()) {
         // Get the node with the lowest f value from the open list
-        Node* best_node = open.top();
-        open.pop();
-        boardOutput(best_node->board);
-        cout << endl << endl;
+        Node* best_node = open.pop();
+        result.nodes_expanded++;
+#if TRACE_EXPANSIONS
+        boardOutput(best_node->board, cout);
+        cout << "\n\n";
+#endif
         depth = best_node->g;
 
-        // Add the best node to the closed list
-        closed[best_node] = true;
-
         // Check if the best node is the goal state
-        if (*best_node == Node(goal_state, 0, 0, nullptr)) {
+        if (memcmp(best_node->board, goal_state, sizeof(goal_state)) == 0) {
+            result.outcome = SearchResult::FOUND;
+            result.goal_node = best_node;
             break;
         }
 
         vector<int>zero = zeroLocation(best_node->board);
         int row = zero[0];
         int column = zero[1];
+        int blank_cell = row * BOARD_SIZE + column;
 
         // Expand the current node
 
@@ -173,224 +772,43 @@ void AStar(int initial_state[BOARD_SIZE][BOARD_SIZE]) {
             int new_board[BOARD_SIZE][BOARD_SIZE];
             memcpy(new_board, best_node->board, sizeof(new_board));
             swap(new_board[row][column], new_board[row - 1][column]);
-            int h = numOutPlace(new_board);
-            Node* new_node = new Node(new_board, best_node->g + 1, h, best_node);
-            if (closed.find(new_node) == closed.end()) {
-                // The child is not in the closed list, check to see if in open list
-                vector<Node*> open_vector;
-                bool already_in_open = false;
-                while (!open.empty()) {
-                    Node* n = open.top();
-                    open.pop();
-                    if (*n == *new_node) {
-                        already_in_open = true;
-                        if (new_node->g < n->g) {
-                            // Found a cheaper path to an already generated node on OPEN
-                            // Reset its parent link to point to BESTNODE
-                            n->parent = best_node;
-                            n->g = new_node->g;
-                            n->f = n->g + n->h;
-                            // We changed the cost of n, we need to reorder the queue
-                            open.push(n);
-                        }
-                        break;
-                    }
-                    else{
-                        open_vector.push_back(n);
-                    }
-                }
-                for(int i=0; i<open_vector.size(); i++) {
-                    open.push(open_vector[i]);
-                }
-                if (!already_in_open) {
-                    new_node->parent = best_node;
-                    open.push(new_node);
-                    best_node->successors.push_back(new_node);
-                }
-            }
-            else {
-                // Node was already in CLOSED
-                auto it_closed = closed.find(new_node);
-                if (it_closed != closed.end()) {
-                    Node* old_node = it_closed->first;
-                    if (new_node->g < old_node->g) {
-                        // Found a cheaper path to an already explored node on CLOSED
-                        // Reset its parent link to point to BESTNODE
-                        old_node->parent = best_node;
-                        old_node->g = new_node->g;
-                        
-                        // Propagate the improvement downward to the old node's successors
-                        propagateImprovement(old_node);
-                        
-                        // Add old node as a successor of BESTNODE
-                        best_node->successors.push_back(old_node);
-                    }
-                }
-            }
+            int h = moveOutPlace(best_node->h, new_board[row][column], blank_cell, blank_cell - BOARD_SIZE);
+            generateChild(best_node, new_board, h, open, index, pool, result.nodes_generated);
         }
         if (column + 1 <= BOARD_SIZE - 1) {
             // // Move the tile RIGHT
             int new_board[BOARD_SIZE][BOARD_SIZE];
             memcpy(new_board, best_node->board, sizeof(new_board));
             swap(new_board[row][column], new_board[row][column + 1]);
-            int h = numOutPlace(new_board);
-            Node* new_node = new Node(new_board, best_node->g + 1, h, best_node);
-            if (closed.find(new_node) == closed.end()) {
-                vector<Node*> open_vector;
-                bool already_in_open = false;
-                while (!open.empty()) {
-                    Node* n = open.top();
-                    open.pop();
-                    if (*n == *new_node) {
-                        already_in_open = true;
-                        if (new_node->g < n->g) {
-                            n->parent = best_node;
-                            n->g = new_node->g;
-                            n->f = n->g + n->h;
-                            open.push(n);
-                        }
-                        break;
-                    }
-                    else{
-                        open_vector.push_back(n);
-                    }
-                }
-                for(int i=0; i<open_vector.size(); i++) {
-                    open.push(open_vector[i]);
-                }
-                if (!already_in_open) {
-                    new_node->parent = best_node;
-                    open.push(new_node);
-                    best_node->successors.push_back(new_node);
-                }
-            }
-            else {
-                auto it_closed = closed.find(new_node);
-                if (it_closed != closed.end()) {
-                    Node* old_node = it_closed->first;
-                    if (new_node->g < old_node->g) {
-                        old_node->parent = best_node;
-                        old_node->g = new_node->g;
-                        propagateImprovement(old_node);
-                        best_node->successors.push_back(old_node);
-                    }
-                }
-            }
+            int h = moveOutPlace(best_node->h, new_board[row][column], blank_cell, blank_cell + 1);
+            generateChild(best_node, new_board, h, open, index, pool, result.nodes_generated);
         }
         if (row + 1 <= BOARD_SIZE - 1) {
             // // Move the tile DOWN
             int new_board[BOARD_SIZE][BOARD_SIZE];
             memcpy(new_board, best_node->board, sizeof(new_board));
             swap(new_board[row][column], new_board[row + 1][column]);
-            int h = numOutPlace(new_board);
-            Node* new_node = new Node(new_board, best_node->g + 1, h, best_node);
-            if (closed.find(new_node) == closed.end()) {
-                vector<Node*> open_vector;
-                bool already_in_open = false;
-                while (!open.empty()) {
-                    Node* n = open.top();
-                    open.pop();
-                    if (*n == *new_node) {
-                        already_in_open = true;
-                        if (new_node->g < n->g) {
-                            n->parent = best_node;
-                            n->g = new_node->g;
-                            n->f = n->g + n->h;
-                            open.push(n);
-                        }
-                        break;
-                    }
-                    else{
-                        open_vector.push_back(n);
-                    }
-                }
-                for(int i=0; i<open_vector.size(); i++) {
-                    open.push(open_vector[i]);
-                }
-                if (!already_in_open) {
-                    new_node->parent = best_node;
-                    open.push(new_node);
-                    best_node->successors.push_back(new_node);
-                }
-            }
-            else {
-                auto it_closed = closed.find(new_node);
-                if (it_closed != closed.end()) {
-                    Node* old_node = it_closed->first;
-                    if (new_node->g < old_node->g) {
-                        old_node->parent = best_node;
-                        old_node->g = new_node->g;
-                        propagateImprovement(old_node);
-                        best_node->successors.push_back(old_node);
-                    }
-                }
-            }
+            int h = moveOutPlace(best_node->h, new_board[row][column], blank_cell, blank_cell + BOARD_SIZE);
+            generateChild(best_node, new_board, h, open, index, pool, result.nodes_generated);
         }
         if (column - 1 >= 0) {
             // // Move the tile LEFT
             int new_board[BOARD_SIZE][BOARD_SIZE];
             memcpy(new_board, best_node->board, sizeof(new_board));
             swap(new_board[row][column], new_board[row][column - 1]);
-            int h = numOutPlace(new_board);
-            Node* new_node = new Node(new_board, best_node->g + 1, h, best_node);
-            if (closed.find(new_node) == closed.end()) {
-                vector<Node*> open_vector;
-                bool already_in_open = false;
-                while (!open.empty()) {
-                    Node* n = open.top();
-                    open.pop();
-                    if (*n == *new_node) {
-                        already_in_open = true;
-                        if (new_node->g < n->g) {
-                            n->parent = best_node;
-                            n->g = new_node->g;
-                            n->f = n->g + n->h;
-                            open.push(n);
-                        }
-                        break;
-                    }
-                    else{
-                        open_vector.push_back(n);
-                    }
-                }
-                for(int i=0; i<open_vector.size(); i++) {
-                    open.push(open_vector[i]);
-                }
-                if (!already_in_open) {
-                    new_node->parent = best_node;
-                    open.push(new_node);
-                    best_node->successors.push_back(new_node);
-                }
-            }
-            else {
-                auto it_closed = closed.find(new_node);
-                if (it_closed != closed.end()) {
-                    Node* old_node = it_closed->first;
-                    if (new_node->g < old_node->g) {
-                        old_node->parent = best_node;
-                        old_node->g = new_node->g;
-                        propagateImprovement(old_node);
-                        best_node->successors.push_back(old_node);
-                    }
-                }
-            }
+            int h = moveOutPlace(best_node->h, new_board[row][column], blank_cell, blank_cell - 1);
+            generateChild(best_node, new_board, h, open, index, pool, result.nodes_generated);
         }
     }
-    cout << "GOAL FOUND ^^" << endl;
-    int NG = open.size() + closed.size();
-    cout << "Nodes Generated = " << NG << endl;
-    int NE = closed.size();
-    cout << "Nodes Expanded = " << NE << endl;
-    int D = depth;
-    cout << "Depth of Tree = " << D << endl;
-    float b_star = NG / D;
-    cout << "Effective Branch Factor = " << b_star << endl;
-    int TP = D + 1;
-    cout << "Total Path = " << TP << endl;
+    result.depth = depth;
+    gettimeofday(&end_time, NULL);
+    result.elapsed_time = (end_time.tv_sec - start_time.tv_sec) * 1000000 + (end_time.tv_usec - start_time.tv_usec);
+    return result;
 }
 
 int main() {
     // The initial state of the puzzle
+#if BOARD_SIZE == 3
     int initial_state1[BOARD_SIZE][BOARD_SIZE] = {
     {2, 8, 3},
     {1, 6, 4},
@@ -399,11 +817,18 @@ int main() {
     {2, 1, 6},
     {4, 0, 8},
     {7, 5, 3}};
-    struct timeval start_time, end_time;
-    gettimeofday(&start_time, NULL);
-    cout << "START BOARD" << endl;
-    AStar(initial_state2);
-    gettimeofday(&end_time, NULL);
-	long elapsed_time = (end_time.tv_sec - start_time.tv_sec) * 1000000 + (end_time.tv_usec - start_time.tv_usec);
-    cout << "Elapsed Time = " << elapsed_time << " micro-seconds" << endl;
+#elif BOARD_SIZE == 4
+    int initial_state2[BOARD_SIZE][BOARD_SIZE] = {
+    {1, 2, 3, 4},
+    {12, 14, 0, 15},
+    {11, 13, 6, 5},
+    {10, 9, 8, 7}};
+#else
+#error "main() has no sample board for this BOARD_SIZE"
+#endif
+    ResultSink sink(cout, ResultSink::Mode(OUTPUT_MODE));
+    NodePool pool;
+    BoardIndex index;
+    SearchResult result = AStar(initial_state2, pool, index);
+    sink.write(initial_state2, result);
 };
\ No newline at end of file
@@ -1,189 +1,4246 @@
 #include <iostream>
+#include <iomanip>
 #include <vector>
 #include <queue>
-#include <unordered_set>
+#include <unordered_map>
+#include <climits>
 #include <algorithm>
 #include <string>
-#include <memory>
+#include <array>
+#include <deque>
+#include <list>
+#include <set>
+#include <sstream>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <type_traits>
+#include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
 
-const vector<int> goal_state = {1, 2, 3, 8, 0, 4, 7, 6, 5};
-const int PUZZLE_SIZE = 9;
-const int BOARD_DIMENSION = 3;
+// Everything below is generated for a board of side N at compile time, so each size gets
+// its own tables and a hot path whose loops over the cells have constant trip counts.
+
+// A board packed into a single word: the tile on cell i lives in bits [b * i, b * (i + 1)),
+// b = tile_bits<N>. Tiles take four bits up to the 15-puzzle and five on bigger boards,
+// whose tiles no longer fit in 64 bits and are packed into a 128-bit word instead.
+template <int N> constexpr int tile_bits = N * N <= 16 ? 4 : 5;
+template <int N> using PackedBoard = conditional_t<N * N * tile_bits<N> <= 64, uint64_t, unsigned __int128>;
+
+// Where the tiles leave a spare field at the top of the word, the cell index of the blank
+// is cached in it; otherwise the blank is found as the one all-zero field.
+template <int N> constexpr bool caches_blank = (N * N + 1) * tile_bits<N> <= 8 * static_cast<int>(sizeof(PackedBoard<N>));
+
+constexpr int absolute(int x) { return x < 0 ? -x : x; }
+
+inline int lowest_set_bit(uint64_t bits) { return __builtin_ctzll(bits); }
+
+inline int lowest_set_bit(unsigned __int128 bits) {
+    uint64_t low = static_cast<uint64_t>(bits);
+    return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll(static_cast<uint64_t>(bits >> 64));
+}
+
+// The goal: tiles numbered clockwise round the board from the top-left corner, spiralling
+// inwards, with the blank on the last cell reached (the centre of a 3x3 board).
+template <int N>
+constexpr array<int, N * N> make_goal_tiles() {
+    array<int, N * N> tiles = {};
+    int top = 0, bottom = N - 1, left = 0, right = N - 1;
+    int tile = 1;
+    while (tile < N * N) {
+        for (int column = left; column <= right && tile < N * N; ++column) tiles[top * N + column] = tile++;
+        top++;
+        for (int row = top; row <= bottom && tile < N * N; ++row) tiles[row * N + right] = tile++;
+        right--;
+        for (int column = right; column >= left && tile < N * N; --column) tiles[bottom * N + column] = tile++;
+        bottom--;
+        for (int row = bottom; row >= top && tile < N * N; --row) tiles[row * N + left] = tile++;
+        left++;
+    }
+    return tiles;
+}
+
+// The cell of every tile on a board given as its tiles, [tile].
+template <int N>
+constexpr array<int, N * N> make_tile_cells(const array<int, N * N> &tiles) {
+    array<int, N * N> cells = {};
+    for (int cell = 0; cell < N * N; ++cell) {
+        cells[tiles[cell]] = cell;
+    }
+    return cells;
+}
+
+template <int N>
+constexpr PackedBoard<N> pack_tiles(const array<int, N * N> &tiles) {
+    PackedBoard<N> state = 0;
+    for (int i = 0; i < N * N; ++i) {
+        state |= static_cast<PackedBoard<N>>(tiles[i]) << (i * tile_bits<N>);
+        if (caches_blank<N> && tiles[i] == 0) {
+            state |= static_cast<PackedBoard<N>>(i) << (8 * sizeof(PackedBoard<N>) - tile_bits<N>);
+        }
+    }
+    return state;
+}
+
+// The lowest bit of every tile's field.
+template <int N>
+constexpr PackedBoard<N> make_field_low_bits() {
+    PackedBoard<N> bits = 0;
+    for (int i = 0; i < N * N; ++i) {
+        bits |= static_cast<PackedBoard<N>>(1) << (i * tile_bits<N>);
+    }
+    return bits;
+}
+
+// Cells reachable from each blank position, in up/right/down/left order (-1 = off the board).
+template <int N>
+constexpr array<array<int, 4>, N * N> make_neighbour_table() {
+    const int dx[4] = {-1, 0, 1, 0};
+    const int dy[4] = {0, 1, 0, -1};
+    array<array<int, 4>, N * N> table = {};
+    for (int cell = 0; cell < N * N; ++cell) {
+        int x = cell / N;
+        int y = cell % N;
+        for (int i = 0; i < 4; ++i) {
+            int nx = x + dx[i];
+            int ny = y + dy[i];
+            bool on_board = nx >= 0 && nx < N && ny >= 0 && ny < N;
+            table[cell][i] = on_board ? nx * N + ny : -1;
+        }
+    }
+    return table;
+}
+
+// A corner check, one per corner of the board. The corner's goal tile can only arrive
+// from one of the two cells beside it, so while the corner lacks its tile and both of
+// those cells already hold theirs, one of the two tiles must step aside and come back:
+// two moves the Manhattan distance does not see.
+struct CornerCheck {
+    int corner, adjacent1, adjacent2;
+    int corner_tile, adjacent1_tile, adjacent2_tile; // Their goal tiles
+};
+
+// What the Manhattan and corner heuristic needs to score boards against one target board:
+// the goal for every search but the backward half of a bidirectional one.
+template <int N>
+struct HeuristicTables {
+    // Manhattan distance of each tile from each cell to the tile's target cell, [tile][cell];
+    // zero for the blank.
+    array<array<int, N * N>, N * N> manhattan;
+
+    array<CornerCheck, 4> corner_checks;
+
+    // The checks that can fire: a target that puts the blank on one of a check's cells
+    // leaves that corner without a conflict to find.
+    unsigned corner_checks_used;
+
+    // For each cell, a bit per corner check that reads it; a move can only change the
+    // checks that read one of the two cells it touches.
+    array<unsigned, N * N> corner_check_masks;
+
+    // Fewest tiles that must step aside for each set of firing corner checks, [bit per
+    // check]: the size of the smallest set of cells holding one of the two adjacent cells
+    // of every firing check. On a 3x3 board neighbouring corners share an edge cell, and
+    // one tile stepping out of it clears both, so counting two moves per firing corner
+    // would overestimate.
+    array<int, 16> corner_cover;
+
+    // The targets again, one byte per vector lane for the SIMD kernels: each tile's target
+    // row and column, each cell's row and column, the tile each cell should hold, and 0xFF
+    // on the lanes that are cells of the board.
+    array<uint8_t, 32> target_row, target_col;
+    array<uint8_t, 32> cell_row, cell_col;
+    array<uint8_t, 32> target_tile;
+    array<uint8_t, 32> in_board;
+};
+
+template <int N>
+constexpr HeuristicTables<N> make_heuristic_tables(const array<int, N * N> &target_tiles) {
+    const array<int, N * N> target_cells = make_tile_cells<N>(target_tiles);
+    HeuristicTables<N> tables = {};
+    for (int tile = 1; tile < N * N; ++tile) {
+        for (int i = 0; i < N * N; ++i) {
+            tables.manhattan[tile][i] = absolute(i / N - target_cells[tile] / N) + absolute(i % N - target_cells[tile] % N);
+        }
+    }
+
+    for (int i = 0; i < N * N; ++i) {
+        tables.target_row[target_tiles[i]] = static_cast<uint8_t>(i / N);
+        tables.target_col[target_tiles[i]] = static_cast<uint8_t>(i % N);
+        tables.cell_row[i] = static_cast<uint8_t>(i / N);
+        tables.cell_col[i] = static_cast<uint8_t>(i % N);
+        tables.target_tile[i] = static_cast<uint8_t>(target_tiles[i]);
+        tables.in_board[i] = 0xFF;
+    }
+
+    const int last = N * N - 1;
+    auto check = [&](int corner, int adjacent1, int adjacent2) {
+        return CornerCheck{corner, adjacent1, adjacent2, target_tiles[corner], target_tiles[adjacent1],
+                           target_tiles[adjacent2]};
+    };
+    tables.corner_checks = {{
+        check(0, 1, N),
+        check(N - 1, N - 2, 2 * N - 1),
+        check(last - N + 1, last - 2 * N + 1, last - N + 2),
+        check(last, last - N, last - 1),
+    }};
+
+    for (int i = 0; i < 4; ++i) {
+        const CornerCheck &corner = tables.corner_checks[i];
+        if (corner.corner_tile == 0 || corner.adjacent1_tile == 0 || corner.adjacent2_tile == 0) continue;
+        tables.corner_checks_used |= 1u << i;
+        tables.corner_check_masks[corner.corner] |= 1u << i;
+        tables.corner_check_masks[corner.adjacent1] |= 1u << i;
+        tables.corner_check_masks[corner.adjacent2] |= 1u << i;
+    }
+
+    for (unsigned firing = 0; firing < 16; ++firing) {
+        int best = 4;
+        for (unsigned choice = 0; choice < 16; ++choice) {
+            int cells[4] = {};
+            int count = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (!(firing & (1u << i))) continue;
+                const CornerCheck &corner = tables.corner_checks[i];
+                int cell = (choice & (1u << i)) ? corner.adjacent1 : corner.adjacent2;
+                bool seen = false;
+                for (int j = 0; j < count; ++j) {
+                    seen = seen || cells[j] == cell;
+                }
+                if (!seen) cells[count++] = cell;
+            }
+            best = count < best ? count : best;
+        }
+        tables.corner_cover[firing] = best;
+    }
+    return tables;
+}
+
+// The N x N sliding-tile puzzle: its packed board and the tables the searches run on.
+template <int N>
+struct SlidingPuzzle {
+    static constexpr int DIMENSION = N;
+    static constexpr int CELLS = N * N;
+
+    using State = PackedBoard<N>;
+    static constexpr int TILE_BITS = tile_bits<N>;
+    static constexpr bool CACHES_BLANK = caches_blank<N>;
+    static constexpr int BLANK_SHIFT = 8 * sizeof(State) - TILE_BITS;
+    static constexpr State TILE_MASK = (static_cast<State>(1) << TILE_BITS) - 1;
+    static constexpr State FIELD_LOW_BITS = make_field_low_bits<N>();
+
+    static constexpr array<int, CELLS> goal_tiles = make_goal_tiles<N>();
+    static constexpr array<int, CELLS> goal_cells = make_tile_cells<N>(goal_tiles);
+    static constexpr State goal = pack_tiles<N>(goal_tiles);
+    static constexpr array<array<int, 4>, CELLS> neighbours = make_neighbour_table<N>();
+
+    using Tables = HeuristicTables<N>;
+    static constexpr Tables goal_tables = make_heuristic_tables<N>(goal_tiles);
+
+    static int tile_at(State state, int cell) {
+        return static_cast<int>((state >> (cell * TILE_BITS)) & TILE_MASK);
+    }
+
+    static int blank_pos(State state) {
+        if constexpr (CACHES_BLANK) {
+            return static_cast<int>(state >> BLANK_SHIFT);
+        } else {
+            // Fold every field onto its lowest bit; the blank's is the only one left clear.
+            State folded = state;
+            for (int bit = 1; bit < TILE_BITS; ++bit) {
+                folded |= state >> bit;
+            }
+            return lowest_set_bit(~folded & FIELD_LOW_BITS) / TILE_BITS;
+        }
+    }
+
+    // Slide the tile on cell `to` into the blank on cell `from`; the blank ends up on `to`.
+    static State move_blank(State state, int from, int to) {
+        State tile = (state >> (to * TILE_BITS)) & TILE_MASK;
+        state = (state & ~(TILE_MASK << (to * TILE_BITS))) | (tile << (from * TILE_BITS));
+        if constexpr (CACHES_BLANK) {
+            state = (state & ~(TILE_MASK << BLANK_SHIFT)) | (static_cast<State>(to) << BLANK_SHIFT);
+        }
+        return state;
+    }
+
+    static State move_blank(State state, int to) { return move_blank(state, blank_pos(state), to); }
+
+    static State pack(const vector<int> &tiles) {
+        array<int, CELLS> cells;
+        copy(tiles.begin(), tiles.end(), cells.begin());
+        return pack_tiles<N>(cells);
+    }
+
+    static vector<int> unpack(State state) {
+        vector<int> tiles(CELLS);
+        for (int i = 0; i < CELLS; ++i) {
+            tiles[i] = tile_at(state, i);
+        }
+        return tiles;
+    }
+
+    struct Hash {
+        size_t operator()(State state) const {
+            if constexpr (sizeof(State) == sizeof(uint64_t)) {
+                return hash<uint64_t>()(state);
+            } else {
+                return hash<uint64_t>()(static_cast<uint64_t>(state)
+                                        ^ static_cast<uint64_t>(state >> 64) * 0x9E3779B97F4A7C15ull);
+            }
+        }
+    };
+};
+
+// Whether the goal can be reached from a board. Every move swaps the blank with a tile,
+// flipping the parity of the permutation that carries the goal onto the board and of the
+// blank's taxicab distance from its goal cell together, so the two parities agree exactly
+// on the boards the goal can be reached from; this holds for any goal and board width.
+// The permutation's parity comes from its cycle count in one pass over the cells.
+template <class Puzzle>
+bool is_solvable(typename Puzzle::State state) {
+    unsigned visited = 0;
+    int cycles = 0;
+    for (int start = 0; start < Puzzle::CELLS; ++start) {
+        if (visited & (1u << start)) continue;
+        cycles++;
+        for (int cell = start; !(visited & (1u << cell)); cell = Puzzle::goal_cells[Puzzle::tile_at(state, cell)]) {
+            visited |= 1u << cell;
+        }
+    }
+    int blank = Puzzle::blank_pos(state);
+    int blank_goal = Puzzle::goal_cells[0];
+    int blank_distance = absolute(blank / Puzzle::DIMENSION - blank_goal / Puzzle::DIMENSION)
+                       + absolute(blank % Puzzle::DIMENSION - blank_goal % Puzzle::DIMENSION);
+    return (Puzzle::CELLS - cycles) % 2 == blank_distance % 2;
+}
+
+using EightPuzzle = SlidingPuzzle<3>;
+using FifteenPuzzle = SlidingPuzzle<4>;
+using TwentyFourPuzzle = SlidingPuzzle<5>;
+
+// Number of 8-puzzle boards reachable from any one start: half of the 9! permutations.
+const int NUM_STATES = 181440;
+
+// Perfect hash of an 8-puzzle board onto [0, NUM_STATES). On a board of odd width a move
+// never changes the parity of the tiles read in row order with the blank skipped (a
+// horizontal move keeps the order, a vertical one rotates three tiles), so the Lehmer-code
+// rank of that 8-tile permutation, halved, is a bijection onto the 8!/2 orders a search can
+// reach; the blank's cell selects one of the nine blocks of that size. Larger boards have
+// far too many states for a flat table.
+int state_rank(EightPuzzle::State state) {
+    int rank = 0;
+    int remaining = EightPuzzle::CELLS - 1;
+    unsigned seen = 0;
+    for (int i = 0; i < EightPuzzle::CELLS; ++i) {
+        int tile = EightPuzzle::tile_at(state, i);
+        if (tile == 0) continue;
+        int smaller_unseen = tile - 1 - __builtin_popcount(seen & ((1u << tile) - 1));
+        rank = rank * remaining-- + smaller_unseen;
+        seen |= 1u << tile;
+    }
+    return EightPuzzle::blank_pos(state) * (NUM_STATES / EightPuzzle::CELLS) + rank / 2;
+}
+
+// Closed list and best-g store as one flat 16-bit entry per reachable board, indexed by
+// state_rank(): the top bit marks the board closed, the low 15 bits hold the cheapest g
+// it has been generated with. Preallocated once, no hashing, no per-insert allocation.
+// Every board is within 31 moves of every other, but engines that are not strictly
+// best-first (HDA* before it has an incumbent) can reach one along far longer paths, so
+// g gets more room than a byte's 7 bits; a g that still does not fit is never admitted.
+// reset() puts back only the entries the last search wrote, not the whole table.
+//
+// A cheaper path to a closed board reopens it. The Manhattan and corner heuristic is
+// consistent and never needs that, but the pattern databases are only admissible.
+class RankClosedTable {
+public:
+    RankClosedTable() : entries(NUM_STATES, UNSEEN) {}
+
+    void reset() {
+        for (int rank : touched) {
+            entries[rank] = UNSEEN;
+        }
+        touched.clear();
+    }
+
+    // True if g beats every path seen to the board so far; records g and reopens the board.
+    bool admit(EightPuzzle::State state, int g) {
+        int rank = state_rank(state);
+        uint16_t &entry = entries[rank];
+        if (g >= (entry & BEST_G)) {
+            return false;
+        }
+        if (entry == UNSEEN) {
+            touched.push_back(rank);
+        }
+        entry = static_cast<uint16_t>(g);
+        return true;
+    }
+
+    // Marks the board closed; false if it already was or a cheaper path to it has been
+    // admitted since this copy was queued.
+    bool close(EightPuzzle::State state, int g) {
+        uint16_t &entry = entries[state_rank(state)];
+        if ((entry & CLOSED) || g > (entry & BEST_G)) {
+            return false;
+        }
+        entry |= CLOSED;
+        return true;
+    }
+
+    bool is_closed(EightPuzzle::State state) const { return entries[state_rank(state)] & CLOSED; }
+
+private:
+    static constexpr uint16_t CLOSED = 0x8000;
+    static constexpr uint16_t BEST_G = 0x7FFF;
+    static constexpr uint16_t UNSEEN = BEST_G;
+
+    vector<uint16_t> entries;
+    vector<int> touched; // Ranks admitted since the last reset()
+};
+
+// The same interface on a node-based hash table, kept so the two can be A/B'd; the only
+// closed list for boards too big to rank.
+template <class Puzzle>
+class HashClosedTable {
+public:
+    using State = typename Puzzle::State;
+
+    void reset() { entries.clear(); }
+
+    bool admit(State state, int g) {
+        auto inserted = entries.emplace(state, Entry{g, false});
+        if (!inserted.second) {
+            if (g >= inserted.first->second.best_g) {
+                return false;
+            }
+            inserted.first->second = Entry{g, false};
+        }
+        return true;
+    }
+
+    bool close(State state, int g) {
+        Entry &entry = entries[state];
+        if (entry.closed || g > entry.best_g) {
+            return false;
+        }
+        entry.closed = true;
+        return true;
+    }
+
+    bool is_closed(State state) const {
+        auto found = entries.find(state);
+        return found != entries.end() && found->second.closed;
+    }
+
+private:
+    struct Entry {
+        int best_g;
+        bool closed;
+    };
+
+    unordered_map<State, Entry, typename Puzzle::Hash> entries;
+};
+
+// The fastest closed list a board size has: the rank table for the 8-puzzle, hashing above.
+template <class Puzzle>
+using FastClosedTable = conditional_t<is_same<Puzzle, EightPuzzle>::value, RankClosedTable, HashClosedTable<Puzzle>>;
+
+enum class SearchEngine { AStar, IDAStar, HDAStar, Bidirectional, MemoryBounded, Oracle };
+enum class ClosedListKind { RankTable, HashTable };
+enum class OpenListKind { Buckets, BinaryHeap };
+
+// Which of two nodes with equal f the bucket queue hands out first.
+enum class TieBreak { HighG, LowG };
+
+enum class HeuristicKind { ManhattanCorner, MisplacedTiles, PatternDatabase };
+
+class PatternDatabase;
+class DistanceOracle;
+
+struct SearchOptions {
+    SearchEngine engine = SearchEngine::AStar;
+    ClosedListKind closed_list = ClosedListKind::RankTable; // Boards larger than 3x3 always hash
+    OpenListKind open_list = OpenListKind::Buckets;
+    TieBreak tie_break = TieBreak::HighG;
+    HeuristicKind heuristic = HeuristicKind::ManhattanCorner;
+    const PatternDatabase *pattern_database = nullptr; // Required for HeuristicKind::PatternDatabase (3x3 only)
+    const DistanceOracle *oracle = nullptr; // Required for SearchEngine::Oracle (3x3 only)
+    int threads = 1; // Workers for SearchEngine::HDAStar
+    size_t memory_budget = size_t(256) << 20; // Bytes of nodes SearchEngine::MemoryBounded may hold
+};
+
+// Hot-path counters, built in with -DSEARCH_COUNTERS=1. Without it COUNT() and the
+// tracing below compile to nothing and the searches pay nothing for them.
+#ifndef SEARCH_COUNTERS
+#define SEARCH_COUNTERS 0
+#endif
+
+// What one search did, as counted by the thread that ran it. A* fills in everything;
+// the other engines only get the heuristic's share, through counted_update().
+struct SearchCounters {
+    long open_pushes = 0;
+    long open_pops = 0;
+    long open_duplicates = 0;   // Children dropped because a copy as cheap was still queued
+    long closed_duplicates = 0; // Children dropped because they had been expanded as cheaply
+    long reopenings = 0;        // Expanded boards queued again at a lower g
+    long stale_pops = 0;        // Queued copies popped after their board was closed
+    long heuristic_updates = 0;
+    double heuristic_seconds = 0;
+    long allocations = 0;       // Times the arena or an open-list bucket grew its storage
+    size_t peak_open = 0;
+    size_t peak_closed = 0;
+    // Kept in every build by SearchEngine::MemoryBounded: nodes dropped to stay within the
+    // budget, and children generated again after being dropped.
+    long forgotten = 0;
+    long regenerated = 0;
+};
+
+thread_local SearchCounters search_counters;
+
+#if SEARCH_COUNTERS
+#define COUNT(counter, amount) (search_counters.counter += (amount))
+#else
+#define COUNT(counter, amount) ((void)0)
+#endif
+
+// Samples of A*'s expansions, written to a binary file: a TraceHeader, then one
+// TraceRecord for every `every`-th expansion of every search the thread runs while the
+// trace is active. Boards are packed as in Puzzle::State, split into two 64-bit halves.
+struct TraceHeader {
+    char magic[8];     // "8PUZTRC"
+    uint32_t version;
+    uint32_t dimension;
+    uint32_t record_size;
+    uint32_t every;
+};
+
+struct TraceRecord {
+    uint64_t expansion; // 1 for the first board a search expands
+    uint64_t state_low, state_high;
+    int16_t g, h;
+    uint32_t open_size;
+};
+
+class SearchTrace {
+public:
+    bool open(const string &path, int dimension, uint32_t sample_every) {
+        every = max<uint32_t>(sample_every, 1);
+        out.open(path, ios::binary | ios::trunc);
+        TraceHeader header = {{'8', 'P', 'U', 'Z', 'T', 'R', 'C', '\0'}, 1, static_cast<uint32_t>(dimension),
+                              sizeof(TraceRecord), every};
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        return static_cast<bool>(out);
+    }
+
+    template <class Node>
+    void record(uint64_t expansion, const Node &node, size_t open_size) {
+        if (expansion % every != 0) {
+            return;
+        }
+        unsigned __int128 state = node.state;
+        TraceRecord record = {expansion, static_cast<uint64_t>(state), static_cast<uint64_t>(state >> 64),
+                              static_cast<int16_t>(node.g), static_cast<int16_t>(node.h),
+                              static_cast<uint32_t>(open_size)};
+        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+
+private:
+    ofstream out;
+    uint32_t every = 1;
+};
+
+// The trace the current thread's A* searches sample into, if any.
+thread_local SearchTrace *active_trace = nullptr;
 
+const int NO_PARENT = -1;
+
+template <class Puzzle>
 struct Node {
-    vector<int> state;
+    typename Puzzle::State state;
     int g, h;
-    shared_ptr<Node> parent; // Change Node *parent to shared_ptr<Node> parent
+    int parent; // Index of the parent in the search's NodeArena, NO_PARENT for the root
 
-    Node(const vector<int> &state, int g, int h, shared_ptr<Node> parent)
+    Node(typename Puzzle::State state, int g, int h, int parent)
         : state(state), g(g), h(h), parent(parent) {}
 };
+
+// The nodes a search has expanded, so children can name their parent by index instead
+// of holding a pointer to a copy of it. Reset in bulk between solves; the storage is
+// kept, so a warm arena does not allocate.
+template <class Puzzle>
+class NodeArena {
+public:
+    int add(const Node<Puzzle> &node) {
+        COUNT(allocations, nodes.size() == nodes.capacity());
+        nodes.push_back(node);
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    const Node<Puzzle> &operator[](int index) const { return nodes[index]; }
+
+    size_t size() const { return nodes.size(); }
+
+    void reset() { nodes.clear(); }
+
+private:
+    vector<Node<Puzzle>> nodes;
+};
+template <class Puzzle>
 struct SearchResult {
-    vector<vector<int>> path;
+    vector<typename Puzzle::State> path;
     int num_nodes_generated;
     int num_nodes_expanded;
     int depth;
     double effective_branching_factor;
     double execution_time;
+    SearchCounters counters; // All zero unless built with SEARCH_COUNTERS, bar forgotten and regenerated
 };
 
-bool operator>(const Node &lhs, const Node &rhs) {
+// The effective branching factor b*: the branching of a uniform tree of depth `depth`
+// holding `nodes` nodes below its root, N = b* + b*^2 + ... + b*^depth. The sum grows
+// with b*, so bisection finds it.
+double effective_branching_factor(double nodes, int depth) {
+    if (depth <= 0 || nodes <= 0) {
+        return 0;
+    }
+    double low = 0, high = max(1.0, nodes);
+    for (int i = 0; i < 100; ++i) {
+        double b = (low + high) / 2, power = 1, total = 0;
+        for (int level = 0; level < depth && total <= nodes; ++level) {
+            power *= b;
+            total += power;
+        }
+        (total < nodes ? low : high) = b;
+    }
+    return (low + high) / 2;
+}
+
+template <class Puzzle>
+bool operator>(const Node<Puzzle> &lhs, const Node<Puzzle> &rhs) {
     return (lhs.g + lhs.h) > (rhs.g + rhs.h);
 }
 
-string state_to_string(const vector<int> &state) {
-    string state_str = "";
-    for (const int &tile : state) {
-        state_str += to_string(tile);
+// The original open list: a binary heap ordered on f alone.
+template <class Puzzle>
+class HeapOpenList {
+public:
+    bool empty() const { return heap.empty(); }
+
+    void push(const Node<Puzzle> &node) {
+        COUNT(allocations, heap.size() == heap.capacity());
+        heap.push_back(node);
+        push_heap(heap.begin(), heap.end(), greater<Node<Puzzle>>());
     }
-    return state_str;
-}
 
-int manhattan_distance(const vector<int> &state) {
-    int distance = 0;
-    for (int i = 0; i < PUZZLE_SIZE; ++i) {
-        if (state[i] == 0) continue;
-        distance += abs(i / BOARD_DIMENSION - (state[i] - 1) / BOARD_DIMENSION)
-                  + abs(i % BOARD_DIMENSION - (state[i] - 1) % BOARD_DIMENSION);
+    Node<Puzzle> pop() {
+        pop_heap(heap.begin(), heap.end(), greater<Node<Puzzle>>());
+        Node<Puzzle> node = heap.back();
+        heap.pop_back();
+        return node;
     }
-    return distance;
-}
 
-int corner_conflict(const vector<int> &state) {
-    int conflicts = 0;
+    void reset() { heap.clear(); }
+
+private:
+    vector<Node<Puzzle>> heap;
+};
+
+// Open list for small integer costs: one bucket per (f, g) pair, so push and pop are
+// O(1) and equal-f nodes come out deepest-first (or shallowest-first) with no comparator.
+template <class Puzzle>
+class BucketOpenList {
+public:
+    explicit BucketOpenList(TieBreak tie_break = TieBreak::HighG) : tie_break(tie_break) {}
 
-    auto check_corner_conflict = [&state](int corner, int adjacent1, int adjacent2, int correct1, int correct2) {
-        if (state[corner] == correct1 && (state[adjacent1] == correct2 || state[adjacent2] == correct2)) {
-            return 2;
+    bool empty() const { return count == 0; }
+
+    void push(const Node<Puzzle> &node) {
+        int f = node.g + node.h;
+        if (f >= static_cast<int>(buckets.size())) {
+            buckets.resize(f + 1);
+            f_counts.resize(f + 1, 0);
         }
-        return 0;
-    };
+        vector<vector<Node<Puzzle>>> &by_g = buckets[f];
+        if (node.g >= static_cast<int>(by_g.size())) {
+            by_g.resize(node.g + 1);
+        }
+        COUNT(allocations, by_g[node.g].size() == by_g[node.g].capacity());
+        by_g[node.g].push_back(node);
+        f_counts[f]++;
+        count++;
+        min_f = min(min_f, f);
+    }
+
+    Node<Puzzle> pop() {
+        while (f_counts[min_f] == 0) {
+            min_f++;
+        }
+        vector<vector<Node<Puzzle>>> &by_g = buckets[min_f];
+        int g = 0;
+        if (tie_break == TieBreak::HighG) {
+            g = static_cast<int>(by_g.size()) - 1;
+            while (by_g[g].empty()) g--;
+        } else {
+            while (by_g[g].empty()) g++;
+        }
+        Node<Puzzle> node = by_g[g].back();
+        by_g[g].pop_back();
+        f_counts[min_f]--;
+        count--;
+        return node;
+    }
+
+    // Empties the queue but keeps every bucket's storage for the next search.
+    void reset(TieBreak new_tie_break) {
+        tie_break = new_tie_break;
+        for (vector<vector<Node<Puzzle>>> &by_g : buckets) {
+            for (vector<Node<Puzzle>> &bucket : by_g) {
+                bucket.clear();
+            }
+        }
+        fill(f_counts.begin(), f_counts.end(), 0);
+        min_f = INT_MAX;
+        count = 0;
+    }
+
+private:
+    TieBreak tie_break;
+    vector<vector<vector<Node<Puzzle>>>> buckets; // [f][g], each used as a stack
+    vector<int> f_counts;
+    int min_f = INT_MAX;
+    size_t count = 0;
+};
+
+// Everything a search allocates, kept between solves so a warm context makes a search
+// allocation-free.
+template <class Puzzle>
+struct SearchContext {
+    NodeArena<Puzzle> arena;
+    FastClosedTable<Puzzle> rank_closed;
+    HashClosedTable<Puzzle> hash_closed;
+    HeapOpenList<Puzzle> heap_open;
+    BucketOpenList<Puzzle> bucket_open;
+    vector<typename Puzzle::State> path; // IDA*'s current path
+};
+
+// Vector kernels for scoring a board from scratch. The searches themselves update h per
+// move from tables, which no kernel beats; these serve every full evaluation (search
+// roots, the misplaced-tiles count, --verify-heuristic). The widest the CPU supports is
+// picked at startup: SSSE3 covers boards up to 4x4, whose 16 four-bit fields fit one
+// 16-byte register; 5x5 boards need AVX2, plus BMI2 to spread their 5-bit fields.
+enum class SimdLevel { Scalar, SSSE3, AVX2 };
 
-    conflicts += check_corner_conflict(0, 1, 3, 1, 2);
-    conflicts += check_corner_conflict(2, 1, 5, 3, 2);
-    conflicts += check_corner_conflict(6, 3, 7, 7, 8);
-    conflicts += check_corner_conflict(8, 5, 7, 5, 6);
+SimdLevel detect_simd_level() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return SimdLevel::SSSE3;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+SimdLevel simd_level = detect_simd_level(); // --simd=off sets Scalar
 
-    return conflicts;
+#if defined(__x86_64__)
+// A board of up to 4x4 with each four-bit field in its own byte, cell i in lane i.
+__attribute__((target("ssse3"))) inline __m128i unpack_fields(uint64_t board) {
+    const __m128i low_bits = _mm_set1_epi8(0x0F);
+    __m128i packed = _mm_cvtsi64_si128(static_cast<long long>(board));
+    __m128i even = _mm_and_si128(packed, low_bits);
+    __m128i odd = _mm_and_si128(_mm_srli_epi16(packed, 4), low_bits);
+    return _mm_unpacklo_epi8(even, odd);
 }
 
-int heuristic(const vector<int> &state) {
-    return manhattan_distance(state) + corner_conflict(state);
+__attribute__((target("ssse3"))) inline __m128i load_lanes(const array<uint8_t, 32> &lanes) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes.data()));
 }
 
-vector<vector<int>> get_successors(const vector<int> &state) {
-    const vector<int> dx = {-1, 0, 1, 0};
-    const vector<int> dy = {0, 1, 0, -1};
-    vector<vector<int>> successors;
-    int zero_pos = find(state.begin(), state.end(), 0) - state.begin();
-    int x = zero_pos / BOARD_DIMENSION;
-    int y = zero_pos % BOARD_DIMENSION;
+template <int N>
+__attribute__((target("ssse3"))) int manhattan_ssse3(uint64_t board, const HeuristicTables<N> &tables) {
+    __m128i tiles = unpack_fields(board);
+    __m128i rows = _mm_shuffle_epi8(load_lanes(tables.target_row), tiles);
+    __m128i cols = _mm_shuffle_epi8(load_lanes(tables.target_col), tiles);
+    __m128i distance = _mm_add_epi8(_mm_abs_epi8(_mm_sub_epi8(rows, load_lanes(tables.cell_row))),
+                                    _mm_abs_epi8(_mm_sub_epi8(cols, load_lanes(tables.cell_col))));
+    __m128i counted = _mm_andnot_si128(_mm_cmpeq_epi8(tiles, _mm_setzero_si128()), load_lanes(tables.in_board));
+    __m128i sums = _mm_sad_epu8(_mm_and_si128(distance, counted), _mm_setzero_si128());
+    return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+}
 
-    for (int i = 0; i < 4; ++i) {
-        int nx = x + dx[i];
-        int ny = y + dy[i];
-        if (nx >= 0 && nx < BOARD_DIMENSION && ny >= 0 && ny < BOARD_DIMENSION) {
-            vector<int> successor = state;
-            swap(successor[zero_pos], successor[nx * BOARD_DIMENSION + ny]);
-            successors.push_back(successor);
-        }
-    }
+template <int N>
+__attribute__((target("ssse3"))) int misplaced_ssse3(uint64_t board, const HeuristicTables<N> &tables) {
+    __m128i tiles = unpack_fields(board);
+    __m128i placed = _mm_or_si128(_mm_cmpeq_epi8(tiles, _mm_setzero_si128()),
+                                  _mm_cmpeq_epi8(tiles, load_lanes(tables.target_tile)));
+    __m128i misplaced = _mm_andnot_si128(placed, load_lanes(tables.in_board));
+    return __builtin_popcount(_mm_movemask_epi8(misplaced));
+}
 
-    return successors;
+// A 5x5 board with each five-bit field in its own byte: BMI2's bit deposit spreads eight
+// fields (40 bits) at a time over eight bytes.
+__attribute__((target("avx2,bmi2"))) inline __m256i unpack_fields(unsigned __int128 board) {
+    const uint64_t FIELDS_40 = (1ULL << 40) - 1;
+    const uint64_t LOW_5_BITS = 0x1F1F1F1F1F1F1F1FULL;
+    return _mm256_set_epi64x(static_cast<long long>(static_cast<uint64_t>(board >> 120) & 0x1F),
+                             static_cast<long long>(_pdep_u64(static_cast<uint64_t>(board >> 80) & FIELDS_40, LOW_5_BITS)),
+                             static_cast<long long>(_pdep_u64(static_cast<uint64_t>(board >> 40) & FIELDS_40, LOW_5_BITS)),
+                             static_cast<long long>(_pdep_u64(static_cast<uint64_t>(board) & FIELDS_40, LOW_5_BITS)));
+}
+
+__attribute__((target("avx2"))) inline __m256i load_lanes_256(const array<uint8_t, 32> &lanes) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lanes.data()));
+}
+
+// lanes[index] for every byte of `index` (all below 32). A byte shuffle only reaches the
+// 16 bytes of its own half, so both halves of the table are looked up and blended.
+__attribute__((target("avx2"))) inline __m256i lookup_32(const array<uint8_t, 32> &lanes, __m256i index) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes.data()));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes.data() + 16));
+    __m256i from_low = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(low), index);
+    __m256i from_high = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(high), index);
+    return _mm256_blendv_epi8(from_low, from_high, _mm256_cmpgt_epi8(index, _mm256_set1_epi8(15)));
+}
+
+__attribute__((target("avx2,bmi2"))) int manhattan_avx2(unsigned __int128 board, const HeuristicTables<5> &tables) {
+    __m256i tiles = unpack_fields(board);
+    __m256i rows = lookup_32(tables.target_row, tiles);
+    __m256i cols = lookup_32(tables.target_col, tiles);
+    __m256i distance = _mm256_add_epi8(_mm256_abs_epi8(_mm256_sub_epi8(rows, load_lanes_256(tables.cell_row))),
+                                       _mm256_abs_epi8(_mm256_sub_epi8(cols, load_lanes_256(tables.cell_col))));
+    __m256i counted = _mm256_andnot_si256(_mm256_cmpeq_epi8(tiles, _mm256_setzero_si256()),
+                                          load_lanes_256(tables.in_board));
+    __m256i sums = _mm256_sad_epu8(_mm256_and_si256(distance, counted), _mm256_setzero_si256());
+    __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    return _mm_cvtsi128_si32(halves) + _mm_extract_epi16(halves, 4);
 }
 
-void print_state(const vector<int> &state) {
-    for (int i = 0; i < PUZZLE_SIZE; ++i) {
-        if (i % BOARD_DIMENSION == 0) {
-            cout << endl;
+__attribute__((target("avx2,bmi2"))) int misplaced_avx2(unsigned __int128 board, const HeuristicTables<5> &tables) {
+    __m256i tiles = unpack_fields(board);
+    __m256i placed = _mm256_or_si256(_mm256_cmpeq_epi8(tiles, _mm256_setzero_si256()),
+                                     _mm256_cmpeq_epi8(tiles, load_lanes_256(tables.target_tile)));
+    __m256i misplaced = _mm256_andnot_si256(placed, load_lanes_256(tables.in_board));
+    return __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(misplaced)));
+}
+#endif
+
+// The heuristic's parts measure distance to the goal unless given another target's tables.
+template <class Puzzle>
+int manhattan_distance(typename Puzzle::State state, const typename Puzzle::Tables &tables = Puzzle::goal_tables) {
+#if defined(__x86_64__)
+    if constexpr (Puzzle::DIMENSION <= 4) {
+        if (simd_level != SimdLevel::Scalar) {
+            return manhattan_ssse3<Puzzle::DIMENSION>(state, tables);
+        }
+    } else {
+        if (simd_level == SimdLevel::AVX2) {
+            return manhattan_avx2(state, tables);
         }
-        cout << state[i] << ' ';
     }
-    cout << endl;
+#endif
+    int distance = 0;
+    for (int i = 0; i < Puzzle::CELLS; ++i) {
+        distance += tables.manhattan[Puzzle::tile_at(state, i)][i];
+    }
+    return distance;
 }
 
-SearchResult astar(const vector<int> &initial_state) {
-    auto start_time = chrono::steady_clock::now();
+// A bit for each of `checks` whose corner conflict fires on the board.
+template <class Puzzle>
+inline unsigned corner_conflicts_firing(typename Puzzle::State state, unsigned checks,
+                                        const typename Puzzle::Tables &tables) {
+    unsigned firing = 0;
+    for (; checks; checks &= checks - 1) {
+        int i = __builtin_ctz(checks);
+        const CornerCheck &check = tables.corner_checks[i];
+        if (Puzzle::tile_at(state, check.corner) != check.corner_tile
+            && Puzzle::tile_at(state, check.adjacent1) == check.adjacent1_tile
+            && Puzzle::tile_at(state, check.adjacent2) == check.adjacent2_tile) {
+            firing |= 1u << i;
+        }
+    }
+    return firing;
+}
 
-    priority_queue<Node, vector<Node>, greater<Node>> open;
-    unordered_set<string> closed;
-    int num_nodes_generated = 0;
-    int num_nodes_expanded = 0;
+template <class Puzzle>
+int corner_conflict(typename Puzzle::State state, const typename Puzzle::Tables &tables = Puzzle::goal_tables) {
+    return 2 * tables.corner_cover[corner_conflicts_firing<Puzzle>(state, tables.corner_checks_used, tables)];
+}
 
-    open.emplace(initial_state, 0, heuristic(initial_state), nullptr);
-    num_nodes_generated++;
+// Change in corner_conflict() when the tile on `from` slides to `to`. Only the checks
+// reading one of those cells can change; the others are read once, from the child.
+template <class Puzzle>
+inline int corner_conflict_delta(typename Puzzle::State parent, typename Puzzle::State child, int from, int to,
+                                 const typename Puzzle::Tables &tables = Puzzle::goal_tables) {
+    unsigned touched = tables.corner_check_masks[from] | tables.corner_check_masks[to];
+    if (!touched) {
+        return 0;
+    }
+    unsigned unchanged = corner_conflicts_firing<Puzzle>(child, tables.corner_checks_used & ~touched, tables);
+    unsigned before = unchanged | corner_conflicts_firing<Puzzle>(parent, touched, tables);
+    unsigned after = unchanged | corner_conflicts_firing<Puzzle>(child, touched, tables);
+    return 2 * (tables.corner_cover[after] - tables.corner_cover[before]);
+}
 
-    while (!open.empty()) {
-        Node current = open.top();
-        open.pop();
+template <class Puzzle>
+int heuristic(typename Puzzle::State state, const typename Puzzle::Tables &tables = Puzzle::goal_tables) {
+    return manhattan_distance<Puzzle>(state, tables) + corner_conflict<Puzzle>(state, tables);
+}
 
-        if (current.state == goal_state) {
-            vector<vector<int>> path;
-            shared_ptr<Node> node = make_shared<Node>(current);
-            while (node) {
-                path.push_back(node->state);
-                node = node->parent;
-            }
-            reverse(path.begin(), path.end());
+// Fixed-capacity successor list so expanding a node never touches the heap. `h` is only
+// filled in by the overload of get_successors() that takes a heuristic.
+template <class Puzzle>
+struct Successors {
+    typename Puzzle::State states[4];
+    int h[4];
+    int count = 0;
 
-            auto end_time = chrono::steady_clock::now();
-            chrono::duration<double> elapsed_time = end_time - start_time;
-            
-            int depth = path.size() - 1;
-            double effective_branching_factor = static_cast<double>(num_nodes_generated) / depth;
+    const typename Puzzle::State *begin() const { return states; }
+    const typename Puzzle::State *end() const { return states + count; }
+};
 
-            return SearchResult{path, num_nodes_generated, num_nodes_expanded, depth, effective_branching_factor, elapsed_time.count()};
+template <class Puzzle>
+Successors<Puzzle> get_successors(typename Puzzle::State state) {
+    Successors<Puzzle> successors;
+    int blank = Puzzle::blank_pos(state);
+    for (int to : Puzzle::neighbours[blank]) {
+        if (to >= 0) {
+            successors.states[successors.count++] = Puzzle::move_blank(state, blank, to);
         }
+    }
+    return successors;
+}
 
-        string state_str = state_to_string(current.state);
-        if (closed.find(state_str) != closed.end()) {
-            continue;
+// Number of ways to place `count` distinct items on the 8-puzzle's cells: 9! / (9 - count)!.
+size_t placement_count(int count) {
+    size_t placements = 1;
+    for (int i = 0; i < count; ++i) {
+        placements *= EightPuzzle::CELLS - i;
+    }
+    return placements;
+}
+
+// Rank of an ordered placement of `count` items on distinct cells, in [0, placement_count(count)).
+inline int placement_rank(const int *cells, int count) {
+    int rank = 0;
+    unsigned used = 0;
+    for (int i = 0; i < count; ++i) {
+        int free_below = cells[i] - __builtin_popcount(used & ((1u << cells[i]) - 1));
+        rank = rank * (EightPuzzle::CELLS - i) + free_below;
+        used |= 1u << cells[i];
+    }
+    return rank;
+}
+
+// A whole file mapped read-only, or nothing if it could not be. The pattern databases,
+// the oracle and board files are all read in place through one of these.
+class MappedFile {
+public:
+    explicit MappedFile(const string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
         }
-        closed.insert(state_str);
-        num_nodes_expanded++;
+        struct stat file_stat;
+        void *data = MAP_FAILED;
+        if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+            data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (data != MAP_FAILED) {
+            mapping = data;
+            mapping_size = file_stat.st_size;
+        }
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() {
+        if (mapping) {
+            munmap(mapping, mapping_size);
+        }
+    }
 
-        for (const vector<int> &successor : get_successors(current.state)) {
-            open.emplace(successor, current.g + 1, heuristic(successor), make_shared<Node>(current));
-            num_nodes_generated++;
+    const uint8_t *data() const { return static_cast<const uint8_t *>(mapping); }
+    size_t size() const { return mapping_size; }
+
+    bool starts_with(const char (&magic)[8]) const { return mapping_size >= 8 && memcmp(mapping, magic, 8) == 0; }
+
+    // For files read front to back once, such as batches of boards.
+    void advise_sequential() const {
+        if (mapping) {
+            madvise(mapping, mapping_size, MADV_SEQUENTIAL);
         }
     }
 
-    return SearchResult{};
+private:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+// FNV-1a over `size` bytes: the checksum the table files carry of their contents.
+uint32_t fnv1a(const uint8_t *bytes, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
 }
 
-int main() {
-    vector<int> initial_state1 = {2, 8, 3, 1, 6, 4, 0, 7, 5};
-    vector<int> initial_state2 = {2, 1, 6, 4, 0, 8, 7, 5, 3};
+// Additive disjoint pattern databases. Each group of tiles gets a table, indexed by
+// placement_rank() of the group's cells, holding the fewest moves *of that group's tiles*
+// needed to bring them home from there; moves of other tiles are free. Since no move is
+// charged to two groups, the sum over groups never overestimates.
+//
+// The tables are laid out as one image -- a PatternDatabaseHeader, then per group a
+// PatternGroupHeader followed by its byte table -- that is written to disk as-is and
+// mapped straight back in by load(), so startup is an mmap and a lookup is a byte read
+// per group. The header carries a checksum of everything after it, so a damaged or stale
+// file is turned away and rebuilt rather than trusted as an admissible heuristic.
+class PatternDatabase {
+public:
+    PatternDatabase() = default;
+    PatternDatabase(const PatternDatabase &) = delete;
+    PatternDatabase &operator=(const PatternDatabase &) = delete;
+    ~PatternDatabase() { unmap(); }
 
-    int choice;
-    cout << "Choose the initial state (1 or 2):" << endl;
-    cout << "1. Initial state 1" << endl;
-    cout << "2. Initial state 2" << endl;
-    cin >> choice;
+    // Builds the tables for `goal` by backward breadth-first search from it.
+    void build(EightPuzzle::State goal, const vector<vector<int>> &tile_groups) {
+        unmap();
+        PatternDatabaseHeader header = {};
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.num_groups = static_cast<uint32_t>(tile_groups.size());
+        header.goal = goal;
 
-    vector<int> initial_state = (choice == 1) ? initial_state1 : initial_state2;
+        storage.assign(reinterpret_cast<const uint8_t *>(&header),
+                       reinterpret_cast<const uint8_t *>(&header) + sizeof(header));
+        for (const vector<int> &tiles : tile_groups) {
+            vector<uint8_t> table = build_table(goal, tiles);
+            PatternGroupHeader group_header = {};
+            for (int tile : tiles) {
+                group_header.tiles |= 1u << tile;
+            }
+            group_header.entries = static_cast<uint32_t>(table.size());
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&group_header);
+            storage.insert(storage.end(), bytes, bytes + sizeof(group_header));
+            storage.insert(storage.end(), table.begin(), table.end());
+        }
+        header.checksum = fnv1a(storage.data() + sizeof(header), storage.size() - sizeof(header));
+        memcpy(storage.data(), &header, sizeof(header));
+        parse(storage.data(), storage.size());
+    }
 
-    SearchResult result = astar(initial_state);
+    bool save(const string &path) const {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char *>(image), static_cast<streamsize>(image_size));
+        return static_cast<bool>(out);
+    }
 
-    if (!result.path.empty()) {
-        cout << "Solution found in " << result.path.size() - 1 << " steps:" << endl;
-        for (const vector<int> &state : result.path) {
-            print_state(state);
+    // Maps a file written by save(); false if it is missing or malformed.
+    bool load(const string &path) {
+        unmap();
+        storage.clear();
+        mapping.reset(new MappedFile(path));
+        if (!mapping->data() || !parse(mapping->data(), mapping->size())) {
+            unmap();
+            return false;
         }
+        return true;
+    }
 
-        cout << "Execution Time: " << result.execution_time << " seconds" << endl;
-        cout << "Number of Nodes Generated: " << result.num_nodes_generated << endl;
-        cout << "Number of Nodes Expanded: " << result.num_nodes_expanded << endl;
-        cout << "Depth of the Tree: " << result.depth << endl;
-        cout << "Effective Branching Factor: " << result.effective_branching_factor << endl;
-        cout << "Total Path: " << result.path.size() << endl;
-    } else {
-        cout << "No solution found." << endl;
+    // True if the loaded tables were built for this goal and these tile groups.
+    bool matches(EightPuzzle::State goal, const vector<vector<int>> &tile_groups) const {
+        if (goal != goal_board || tile_groups.size() != groups.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < groups.size(); ++i) {
+            if (tile_groups[i].size() != static_cast<size_t>(groups[i].num_tiles)
+                || !equal(tile_groups[i].begin(), tile_groups[i].end(), groups[i].tiles)) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    return 0;
-}
\ No newline at end of file
+    int lookup(EightPuzzle::State state) const {
+        int cell_of[EightPuzzle::CELLS];
+        for (int cell = 0; cell < EightPuzzle::CELLS; ++cell) {
+            cell_of[EightPuzzle::tile_at(state, cell)] = cell;
+        }
+        int h = 0;
+        for (const Group &group : groups) {
+            int cells[EightPuzzle::CELLS];
+            for (int i = 0; i < group.num_tiles; ++i) {
+                cells[i] = cell_of[group.tiles[i]];
+            }
+            h += group.table[placement_rank(cells, group.num_tiles)];
+        }
+        return h;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'8', 'P', 'U', 'Z', 'P', 'D', 'B', '\0'};
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint8_t UNREACHED = 0xFF;
+
+    struct PatternDatabaseHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_groups;
+        EightPuzzle::State goal;
+        uint32_t checksum; // FNV-1a of the group headers and tables
+        uint32_t reserved;
+    };
+
+    struct PatternGroupHeader {
+        uint32_t tiles; // Bit t set for every tile t in the group
+        uint32_t entries;
+    };
+
+    struct Group {
+        int tiles[EightPuzzle::CELLS];
+        int num_tiles;
+        const uint8_t *table;
+    };
+
+    vector<Group> groups;
+    EightPuzzle::State goal_board = 0;
+    const uint8_t *image = nullptr;
+    size_t image_size = 0;
+    vector<uint8_t> storage; // The image when it was built rather than loaded
+    unique_ptr<MappedFile> mapping; // The file the image was loaded from
+
+    void unmap() {
+        mapping.reset();
+        groups.clear();
+        image = nullptr;
+        image_size = 0;
+    }
+
+    bool parse(const uint8_t *data, size_t size) {
+        PatternDatabaseHeader header;
+        if (size < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            return false;
+        }
+        groups.clear();
+        unsigned seen_tiles = 0;
+        size_t offset = sizeof(header);
+        for (uint32_t i = 0; i < header.num_groups; ++i) {
+            PatternGroupHeader group_header;
+            if (size - offset < sizeof(group_header)) {
+                return false;
+            }
+            memcpy(&group_header, data + offset, sizeof(group_header));
+            offset += sizeof(group_header);
+
+            Group group = {};
+            for (int tile = 1; tile < EightPuzzle::CELLS; ++tile) {
+                if (group_header.tiles & (1u << tile)) {
+                    group.tiles[group.num_tiles++] = tile;
+                }
+            }
+            if ((group_header.tiles & (seen_tiles | 1u)) != 0 || group.num_tiles == 0
+                || group_header.entries != placement_count(group.num_tiles)
+                || size - offset < group_header.entries) {
+                return false;
+            }
+            seen_tiles |= group_header.tiles;
+            group.table = data + offset;
+            offset += group_header.entries;
+            groups.push_back(group);
+        }
+        if (header.checksum != fnv1a(data + sizeof(header), offset - sizeof(header))) {
+            groups.clear();
+            return false;
+        }
+        goal_board = header.goal;
+        image = data;
+        image_size = offset;
+        return true;
+    }
+
+    // 0-1 breadth-first search over where the group's tiles and the blank are. Moving a
+    // group tile costs one, moving any other tile costs nothing; the group's table entry is
+    // the cheapest cost over every position of the blank.
+    static vector<uint8_t> build_table(EightPuzzle::State goal, const vector<int> &tiles) {
+        int num_tiles = static_cast<int>(tiles.size());
+        int blank = num_tiles; // The blank is the last item of an abstract state
+        vector<uint8_t> distance(placement_count(num_tiles + 1), UNREACHED);
+        vector<bool> expanded(distance.size(), false);
+        vector<uint8_t> table(placement_count(num_tiles), UNREACHED);
+
+        array<int, EightPuzzle::CELLS> start;
+        for (int i = 0; i < num_tiles; ++i) {
+            for (int cell = 0; cell < EightPuzzle::CELLS; ++cell) {
+                if (EightPuzzle::tile_at(goal, cell) == tiles[i]) start[i] = cell;
+            }
+        }
+        start[blank] = EightPuzzle::blank_pos(goal);
+
+        deque<array<int, EightPuzzle::CELLS>> frontier;
+        distance[placement_rank(start.data(), num_tiles + 1)] = 0;
+        frontier.push_back(start);
+        while (!frontier.empty()) {
+            array<int, EightPuzzle::CELLS> cells = frontier.front();
+            frontier.pop_front();
+            int rank = placement_rank(cells.data(), num_tiles + 1);
+            if (expanded[rank]) continue;
+            expanded[rank] = true;
+            int d = distance[rank];
+
+            uint8_t &entry = table[placement_rank(cells.data(), num_tiles)];
+            entry = min<uint8_t>(entry, d);
+
+            for (int to : EightPuzzle::neighbours[cells[blank]]) {
+                if (to < 0) continue;
+                array<int, EightPuzzle::CELLS> next = cells;
+                int cost = 0;
+                for (int i = 0; i < num_tiles; ++i) {
+                    if (next[i] == to) {
+                        next[i] = cells[blank];
+                        cost = 1;
+                    }
+                }
+                next[blank] = to;
+                uint8_t &next_distance = distance[placement_rank(next.data(), num_tiles + 1)];
+                if (d + cost < next_distance) {
+                    next_distance = static_cast<uint8_t>(d + cost);
+                    if (cost == 0) {
+                        frontier.push_front(next);
+                    } else {
+                        frontier.push_back(next);
+                    }
+                }
+            }
+        }
+        return table;
+    }
+};
+
+// Exact distance to the goal of every 8-puzzle board, found once by a backward
+// breadth-first search from the goal and kept as one nibble per board, indexed by
+// state_rank(): 181440 boards in about 90 KB. The longest distance is over 15, so a
+// nibble holds the distance mod 16. That is enough to solve, because a move always changes
+// the distance by exactly one: the neighbour one move closer to the goal is the one whose
+// nibble is one less, mod 16, and following such neighbours walks an optimal path.
+//
+// Like the pattern databases, the image -- a DistanceOracleHeader and then the packed
+// nibbles -- is written to disk as-is and mapped straight back in by load(). The header
+// carries a checksum of the nibbles, so a damaged or stale file is turned away and rebuilt
+// rather than walked.
+class DistanceOracle {
+public:
+    DistanceOracle() = default;
+    DistanceOracle(const DistanceOracle &) = delete;
+    DistanceOracle &operator=(const DistanceOracle &) = delete;
+    ~DistanceOracle() { unmap(); }
+
+    void build(EightPuzzle::State goal) {
+        unmap();
+        vector<uint8_t> distance(NUM_STATES, UNREACHED);
+        vector<EightPuzzle::State> level = {goal};
+        distance[state_rank(goal)] = 0;
+        for (int d = 1; !level.empty(); ++d) {
+            vector<EightPuzzle::State> next_level;
+            for (EightPuzzle::State state : level) {
+                for (EightPuzzle::State child : get_successors<EightPuzzle>(state)) {
+                    uint8_t &entry = distance[state_rank(child)];
+                    if (entry == UNREACHED) {
+                        entry = static_cast<uint8_t>(d);
+                        next_level.push_back(child);
+                    }
+                }
+            }
+            level.swap(next_level);
+        }
+
+        DistanceOracleHeader header = {};
+        memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.entries = NUM_STATES;
+        header.goal = goal;
+        storage.assign(sizeof(header) + NUM_STATES / 2, 0);
+        uint8_t *nibbles = storage.data() + sizeof(header);
+        for (int rank = 0; rank < NUM_STATES; ++rank) {
+            nibbles[rank / 2] |= (distance[rank] & NIBBLE) << (rank % 2 * 4);
+        }
+        header.checksum = fnv1a(nibbles, NUM_STATES / 2);
+        memcpy(storage.data(), &header, sizeof(header));
+        parse(storage.data(), storage.size());
+    }
+
+    bool save(const string &path) const {
+        ofstream out(path, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char *>(image), static_cast<streamsize>(image_size));
+        return static_cast<bool>(out);
+    }
+
+    // Maps a file written by save(); false if it is missing or malformed.
+    bool load(const string &path) {
+        unmap();
+        storage.clear();
+        mapping.reset(new MappedFile(path));
+        if (!mapping->data() || !parse(mapping->data(), mapping->size())) {
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+    bool matches(EightPuzzle::State goal) const { return image != nullptr && goal == goal_board; }
+
+    // Sets `next` to the board one move closer to the goal; false if no neighbour's
+    // distance is one less, which only a table that does not hold true distances allows.
+    // `state` must be solvable and not the goal.
+    bool next_state(EightPuzzle::State state, EightPuzzle::State &next) const {
+        int closer = (residue(state) + NIBBLE) & NIBBLE;
+        int blank = EightPuzzle::blank_pos(state);
+        for (int to : EightPuzzle::neighbours[blank]) {
+            if (to < 0) continue;
+            EightPuzzle::State child = EightPuzzle::move_blank(state, blank, to);
+            if (residue(child) == closer) {
+                next = child;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // An optimal path from `state` to the goal, both ends included; empty if there is none
+    // or the table fails to lead to the goal within MAX_DISTANCE moves.
+    vector<EightPuzzle::State> path(EightPuzzle::State state) const {
+        vector<EightPuzzle::State> path;
+        if (!is_solvable<EightPuzzle>(state)) {
+            return path;
+        }
+        path.push_back(state);
+        while (state != goal_board) {
+            if (path.size() > MAX_DISTANCE || !next_state(state, state)) {
+                return vector<EightPuzzle::State>();
+            }
+            path.push_back(state);
+        }
+        return path;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'8', 'P', 'U', 'Z', 'O', 'R', 'C', '\0'};
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint8_t UNREACHED = 0xFF;
+    static constexpr uint8_t NIBBLE = 0xF;
+    static constexpr size_t MAX_DISTANCE = 31; // No 8-puzzle board is farther from the goal
+
+    struct DistanceOracleHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t entries;
+        EightPuzzle::State goal;
+        uint32_t checksum; // FNV-1a of the packed nibbles
+        uint32_t reserved;
+    };
+
+    const uint8_t *nibbles = nullptr;
+    EightPuzzle::State goal_board = 0;
+    const uint8_t *image = nullptr;
+    size_t image_size = 0;
+    vector<uint8_t> storage; // The image when it was built rather than loaded
+    unique_ptr<MappedFile> mapping; // The file the image was loaded from
+
+    // The board's distance to the goal, mod 16.
+    int residue(EightPuzzle::State state) const {
+        int rank = state_rank(state);
+        return (nibbles[rank / 2] >> (rank % 2 * 4)) & NIBBLE;
+    }
+
+    void unmap() {
+        mapping.reset();
+        nibbles = nullptr;
+        image = nullptr;
+        image_size = 0;
+    }
+
+    bool parse(const uint8_t *data, size_t size) {
+        DistanceOracleHeader header;
+        if (size < sizeof(header)) {
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+            || header.entries != NUM_STATES || size - sizeof(header) < NUM_STATES / 2
+            || header.checksum != fnv1a(data + sizeof(header), NUM_STATES / 2)) {
+            return false;
+        }
+        goal_board = header.goal;
+        nibbles = data + sizeof(header);
+        if (residue(goal_board) != 0) {
+            nibbles = nullptr;
+            return false;
+        }
+        image = data;
+        image_size = sizeof(header) + NUM_STATES / 2;
+        return true;
+    }
+};
+
+// The heuristics the searches can be instantiated with. Besides evaluating a board from
+// scratch, each can derive a child's h from its parent's after `tile` slid from cell
+// `from` to cell `to`. `Puzzle` names the board they score.
+template <class BoardPuzzle>
+struct ManhattanCornerHeuristic {
+    using Puzzle = BoardPuzzle;
+    using State = typename Puzzle::State;
+
+    const typename Puzzle::Tables *tables = &Puzzle::goal_tables; // The target the distance is to
+
+    int operator()(State state) const { return heuristic<Puzzle>(state, *tables); }
+
+    int update(State parent, State child, int parent_h, int tile, int from, int to) const {
+        return parent_h - tables->manhattan[tile][from] + tables->manhattan[tile][to]
+             + corner_conflict_delta<Puzzle>(parent, child, from, to, *tables);
+    }
+};
+
+// The number of tiles off their goal cell: weaker than Manhattan distance, kept as the
+// baseline the other heuristics are measured against.
+template <class BoardPuzzle>
+struct MisplacedTilesHeuristic {
+    using Puzzle = BoardPuzzle;
+    using State = typename Puzzle::State;
+
+    int operator()(State state) const {
+#if defined(__x86_64__)
+        if constexpr (Puzzle::DIMENSION <= 4) {
+            if (simd_level != SimdLevel::Scalar) {
+                return misplaced_ssse3<Puzzle::DIMENSION>(state, Puzzle::goal_tables);
+            }
+        } else {
+            if (simd_level == SimdLevel::AVX2) {
+                return misplaced_avx2(state, Puzzle::goal_tables);
+            }
+        }
+#endif
+        int misplaced = 0;
+        for (int cell = 0; cell < Puzzle::CELLS; ++cell) {
+            int tile = Puzzle::tile_at(state, cell);
+            misplaced += tile != 0 && tile != Puzzle::goal_tiles[cell];
+        }
+        return misplaced;
+    }
+
+    int update(State, State, int parent_h, int tile, int from, int to) const {
+        return parent_h - (Puzzle::goal_tiles[from] != tile) + (Puzzle::goal_tiles[to] != tile);
+    }
+};
+
+struct PatternDatabaseHeuristic {
+    using Puzzle = EightPuzzle;
+    using State = EightPuzzle::State;
+
+    const PatternDatabase &pattern_database;
+
+    int operator()(State state) const { return pattern_database.lookup(state); }
+
+    int update(State, State child, int, int, int, int) const { return pattern_database.lookup(child); }
+};
+
+// The heuristic's update for moving `tile` from `from` into the blank at `blank`, counted
+// and timed in the thread's search_counters when those are built in.
+template <class Heuristic>
+int counted_update(const Heuristic &heuristic, typename Heuristic::State parent, typename Heuristic::State child,
+                   int h, int tile, int from, int blank) {
+#if SEARCH_COUNTERS
+    auto start_time = chrono::steady_clock::now();
+    int child_h = heuristic.update(parent, child, h, tile, from, blank);
+    chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+    search_counters.heuristic_updates++;
+    search_counters.heuristic_seconds += elapsed_time.count();
+    return child_h;
+#else
+    return heuristic.update(parent, child, h, tile, from, blank);
+#endif
+}
+
+// Successors of a board whose h is `h`, each scored by updating h for the one tile that moved.
+template <class Heuristic>
+Successors<typename Heuristic::Puzzle> get_successors(typename Heuristic::State state, int h,
+                                                      const Heuristic &heuristic) {
+    using Puzzle = typename Heuristic::Puzzle;
+    Successors<Puzzle> successors;
+    int blank = Puzzle::blank_pos(state);
+    for (int from : Puzzle::neighbours[blank]) {
+        if (from >= 0) {
+            typename Puzzle::State child = Puzzle::move_blank(state, blank, from);
+            successors.states[successors.count] = child;
+            successors.h[successors.count] =
+                counted_update(heuristic, state, child, h, Puzzle::tile_at(state, from), from, blank);
+            successors.count++;
+        }
+    }
+    return successors;
+}
+
+template <class Puzzle>
+void print_state(typename Puzzle::State state) {
+    int width = Puzzle::CELLS > 10 ? 2 : 1;
+    for (int i = 0; i < Puzzle::CELLS; ++i) {
+        if (i % Puzzle::DIMENSION == 0) {
+            cout << '\n';
+        }
+        cout << setw(width) << Puzzle::tile_at(state, i) << ' ';
+    }
+    cout << '\n';
+}
+
+template <class Heuristic, class ClosedList, class OpenList>
+SearchResult<typename Heuristic::Puzzle> astar_with(typename Heuristic::State initial_state, const Heuristic &heuristic,
+                                                    ClosedList &closed, OpenList &open,
+                                                    NodeArena<typename Heuristic::Puzzle> &arena) {
+    using Puzzle = typename Heuristic::Puzzle;
+    auto start_time = chrono::steady_clock::now();
+
+    int num_nodes_generated = 0;
+    int num_nodes_expanded = 0;
+
+    closed.admit(initial_state, 0);
+    open.push(Node<Puzzle>(initial_state, 0, heuristic(initial_state), NO_PARENT));
+    num_nodes_generated++;
+    COUNT(open_pushes, 1);
+
+    while (!open.empty()) {
+        Node<Puzzle> current = open.pop();
+        COUNT(open_pops, 1);
+
+        if (current.state == Puzzle::goal) {
+            vector<typename Puzzle::State> path;
+            path.push_back(current.state);
+            for (int index = current.parent; index != NO_PARENT; index = arena[index].parent) {
+                path.push_back(arena[index].state);
+            }
+            reverse(path.begin(), path.end());
+
+            auto end_time = chrono::steady_clock::now();
+            chrono::duration<double> elapsed_time = end_time - start_time;
+
+            int depth = path.size() - 1;
+            double branching_factor = effective_branching_factor(num_nodes_generated - 1, depth);
+
+            return SearchResult<Puzzle>{path, num_nodes_generated, num_nodes_expanded, depth, branching_factor, elapsed_time.count(), {}};
+        }
+
+        if (!closed.close(current.state, current.g)) {
+            COUNT(stale_pops, 1);
+            continue;
+        }
+        num_nodes_expanded++;
+        int current_index = arena.add(current);
+#if SEARCH_COUNTERS
+        SearchCounters &counters = search_counters;
+        counters.peak_open = max<size_t>(counters.peak_open, counters.open_pushes - counters.open_pops);
+        counters.peak_closed = max(counters.peak_closed, arena.size());
+        if (active_trace != nullptr) {
+            active_trace->record(num_nodes_expanded, current, counters.open_pushes - counters.open_pops);
+        }
+#endif
+
+        Successors<Puzzle> successors = get_successors(current.state, current.h, heuristic);
+        for (int i = 0; i < successors.count; ++i) {
+#if SEARCH_COUNTERS
+            bool was_closed = closed.is_closed(successors.states[i]);
+#endif
+            if (!closed.admit(successors.states[i], current.g + 1)) {
+#if SEARCH_COUNTERS
+                (was_closed ? counters.closed_duplicates : counters.open_duplicates)++;
+#endif
+                continue;
+            }
+#if SEARCH_COUNTERS
+            counters.reopenings += was_closed;
+#endif
+            open.push(Node<Puzzle>(successors.states[i], current.g + 1, successors.h[i], current_index));
+            num_nodes_generated++;
+            COUNT(open_pushes, 1);
+        }
+    }
+
+    return SearchResult<Puzzle>{};
+}
+
+template <class Heuristic, class ClosedList>
+SearchResult<typename Heuristic::Puzzle> astar_with(typename Heuristic::State initial_state, const Heuristic &heuristic,
+                                                    ClosedList &closed, const SearchOptions &options,
+                                                    SearchContext<typename Heuristic::Puzzle> &context) {
+    closed.reset();
+    context.arena.reset();
+    if (options.open_list == OpenListKind::BinaryHeap) {
+        context.heap_open.reset();
+        return astar_with(initial_state, heuristic, closed, context.heap_open, context.arena);
+    }
+    context.bucket_open.reset(options.tie_break);
+    return astar_with(initial_state, heuristic, closed, context.bucket_open, context.arena);
+}
+
+template <class Heuristic>
+SearchResult<typename Heuristic::Puzzle> astar_with(typename Heuristic::State initial_state, const Heuristic &heuristic,
+                                                    const SearchOptions &options,
+                                                    SearchContext<typename Heuristic::Puzzle> &context) {
+    if (options.closed_list == ClosedListKind::HashTable) {
+        return astar_with(initial_state, heuristic, context.hash_closed, options, context);
+    }
+    return astar_with(initial_state, heuristic, context.rank_closed, options, context);
+}
+
+// Calls f with the heuristic options.heuristic names and returns what f returns. Pattern
+// databases exist for the 8-puzzle only; other sizes never instantiate that branch.
+template <class Puzzle, class F>
+auto with_heuristic(const SearchOptions &options, F &&f) {
+    if constexpr (is_same<Puzzle, EightPuzzle>::value) {
+        if (options.heuristic == HeuristicKind::PatternDatabase) {
+            return f(PatternDatabaseHeuristic{*options.pattern_database});
+        }
+    }
+    if (options.heuristic == HeuristicKind::MisplacedTiles) {
+        return f(MisplacedTilesHeuristic<Puzzle>());
+    }
+    return f(ManhattanCornerHeuristic<Puzzle>());
+}
+
+// with_heuristic for the engines, which turn away a board the goal cannot be reached from
+// before searching: an empty path comes back at once instead of after exhausting every
+// reachable board.
+template <class Puzzle, class F>
+SearchResult<Puzzle> search_with_heuristic(typename Puzzle::State initial_state, const SearchOptions &options,
+                                           F &&search) {
+    if (!is_solvable<Puzzle>(initial_state)) {
+        return SearchResult<Puzzle>{};
+    }
+    return with_heuristic<Puzzle>(options, search);
+}
+
+template <class Puzzle>
+SearchResult<Puzzle> astar(typename Puzzle::State initial_state, const SearchOptions &options,
+                           SearchContext<Puzzle> &context) {
+    return search_with_heuristic<Puzzle>(initial_state, options, [&](const auto &heuristic) {
+        return astar_with(initial_state, heuristic, options, context);
+    });
+}
+
+template <class Puzzle>
+SearchResult<Puzzle> astar(typename Puzzle::State initial_state, const SearchOptions &options = SearchOptions()) {
+    SearchContext<Puzzle> context;
+    return astar(initial_state, options, context);
+}
+
+// Iterative-deepening A*: repeated depth-first searches bounded by f over one board
+// that is moved and moved back in place, with h carried down the recursion and updated per
+// move. Nothing is stored but the current path, which lives in a reused buffer.
+template <class Heuristic>
+class IdaStarSearch {
+public:
+    using Puzzle = typename Heuristic::Puzzle;
+    using State = typename Puzzle::State;
+
+    IdaStarSearch(const Heuristic &heuristic, vector<State> &path) : heuristic(heuristic), path(path) {}
+
+    SearchResult<Puzzle> run(State initial_state) {
+        auto start_time = chrono::steady_clock::now();
+
+        board = initial_state;
+        path.clear();
+        path.push_back(board);
+        num_nodes_generated = 1;
+        num_nodes_expanded = 0;
+
+        int h = heuristic(board);
+        int bound = h;
+        // No 8-puzzle board is more than 31 moves from the goal and no 15-puzzle board more
+        // than 80, and the heuristics stay within a small multiple of that, so a bound past
+        // MAX_BOUND means the goal is unreachable.
+        while (bound <= MAX_BOUND) {
+            int next_bound = search(0, h, bound, -1);
+            if (next_bound == FOUND) {
+                chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+                int depth = path.size() - 1;
+                double branching_factor = effective_branching_factor(num_nodes_generated - 1, depth);
+                return SearchResult<Puzzle>{path, num_nodes_generated, num_nodes_expanded, depth,
+                                            branching_factor, elapsed_time.count(), {}};
+            }
+            bound = next_bound;
+        }
+        return SearchResult<Puzzle>{};
+    }
+
+private:
+    static constexpr int FOUND = -1;
+    static constexpr int MAX_BOUND = 16 * Puzzle::CELLS;
+
+    const Heuristic &heuristic;
+    vector<State> &path;
+    State board = 0;
+    int num_nodes_generated = 0;
+    int num_nodes_expanded = 0;
+
+    // Returns FOUND, or the smallest f that exceeded the bound below this node.
+    int search(int g, int h, int bound, int previous_blank) {
+        int f = g + h;
+        if (f > bound) {
+            return f;
+        }
+        if (board == Puzzle::goal) {
+            return FOUND;
+        }
+        num_nodes_expanded++;
+
+        int smallest_exceeded = INT_MAX;
+        int blank = Puzzle::blank_pos(board);
+        for (int to : Puzzle::neighbours[blank]) {
+            // Sliding the tile straight back would undo the move that led here
+            if (to < 0 || to == previous_blank) continue;
+
+            State parent = board;
+            int tile = Puzzle::tile_at(board, to);
+            board = Puzzle::move_blank(board, blank, to);
+            num_nodes_generated++;
+            path.push_back(board);
+
+            int t = search(g + 1, counted_update(heuristic, parent, board, h, tile, to, blank), bound, blank);
+            if (t == FOUND) {
+                return FOUND;
+            }
+
+            path.pop_back();
+            board = parent;
+            smallest_exceeded = min(smallest_exceeded, t);
+        }
+        return smallest_exceeded;
+    }
+};
+
+template <class Heuristic>
+SearchResult<typename Heuristic::Puzzle> idastar_with(typename Heuristic::State initial_state,
+                                                      const Heuristic &heuristic,
+                                                      SearchContext<typename Heuristic::Puzzle> &context) {
+    return IdaStarSearch<Heuristic>(heuristic, context.path).run(initial_state);
+}
+
+template <class Puzzle>
+SearchResult<Puzzle> idastar(typename Puzzle::State initial_state, const SearchOptions &options,
+                             SearchContext<Puzzle> &context) {
+    return search_with_heuristic<Puzzle>(initial_state, options, [&](const auto &heuristic) {
+        return idastar_with(initial_state, heuristic, context);
+    });
+}
+
+// Hash-distributed A*: one A* per worker, each owning the boards that hash to it. A worker
+// expands only boards it owns; children owned elsewhere are buffered per owner and
+// handed over in batches through the owner's lock-free inbox. The first goal an owner
+// pops sets an incumbent cost and every node with f at or above it is pruned, so with an
+// admissible heuristic the search ends with an optimal path once no worker has a node
+// below the incumbent and nothing is in flight.
+//
+// Each worker keeps its own SearchContext (bucket open list, the board size's fastest
+// closed table, node arena). A parent link names a node in any worker's arena as
+// index * num_workers + worker.
+template <class Heuristic>
+class HdaStarSearch {
+public:
+    using Puzzle = typename Heuristic::Puzzle;
+    using State = typename Puzzle::State;
+
+    HdaStarSearch(const Heuristic &heuristic, const SearchOptions &options)
+        : heuristic(heuristic), tie_break(options.tie_break), workers(max(options.threads, 1)) {}
+
+    SearchResult<Puzzle> run(State initial_state) {
+        auto start_time = chrono::steady_clock::now();
+
+        int num_workers = static_cast<int>(workers.size());
+        for (Worker &worker : workers) {
+            worker.context.reset(new SearchContext<Puzzle>());
+            worker.context->rank_closed.reset();
+            worker.context->arena.reset();
+            worker.context->bucket_open.reset(tie_break);
+            worker.outgoing.assign(num_workers, nullptr);
+        }
+        incumbent = INT_MAX;
+        goal_ref = NO_PARENT;
+        outstanding = num_workers;
+        finished = false;
+
+        Worker &owner = workers[owner_of(initial_state)];
+        owner.context->rank_closed.admit(initial_state, 0);
+        owner.context->bucket_open.push(Node<Puzzle>(initial_state, 0, heuristic(initial_state), NO_PARENT));
+        owner.num_nodes_generated++;
+
+        vector<thread> threads;
+        for (int i = 0; i < num_workers; ++i) {
+            threads.emplace_back([this, i] { work(i); });
+        }
+        for (thread &worker : threads) {
+            worker.join();
+        }
+
+        int num_nodes_generated = 0;
+        int num_nodes_expanded = 0;
+        for (Worker &worker : workers) {
+            num_nodes_generated += worker.num_nodes_generated;
+            num_nodes_expanded += worker.num_nodes_expanded;
+            // The workers counted on their own threads; the caller's counters get the total
+            search_counters.heuristic_updates += worker.counters.heuristic_updates;
+            search_counters.heuristic_seconds += worker.counters.heuristic_seconds;
+        }
+        if (goal_ref == NO_PARENT) {
+            return SearchResult<Puzzle>{};
+        }
+
+        vector<State> path;
+        for (int ref = goal_ref; ref != NO_PARENT;) {
+            const Node<Puzzle> &node = workers[ref % num_workers].context->arena[ref / num_workers];
+            path.push_back(node.state);
+            ref = node.parent;
+        }
+        reverse(path.begin(), path.end());
+
+        chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+        int depth = path.size() - 1;
+        double branching_factor = effective_branching_factor(num_nodes_generated - 1, depth);
+        return SearchResult<Puzzle>{path, num_nodes_generated, num_nodes_expanded, depth, branching_factor,
+                                    elapsed_time.count(), {}};
+    }
+
+private:
+    static constexpr size_t BATCH_SIZE = 64;
+    static constexpr int EXPANSIONS_PER_POLL = 64;
+
+    struct Batch {
+        Batch *next = nullptr;
+        vector<Node<Puzzle>> nodes;
+    };
+
+    // Multi-producer single-consumer inbox: senders push batches onto an intrusive stack
+    // with a CAS and the owner takes the whole stack with one exchange.
+    class Inbox {
+    public:
+        void push(Batch *batch) {
+            batch->next = head.load(memory_order_relaxed);
+            while (!head.compare_exchange_weak(batch->next, batch, memory_order_release, memory_order_relaxed)) {
+            }
+        }
+
+        Batch *take_all() { return head.exchange(nullptr, memory_order_acquire); }
+
+    private:
+        atomic<Batch *> head{nullptr};
+    };
+
+    struct Worker {
+        unique_ptr<SearchContext<Puzzle>> context;
+        Inbox inbox;
+        vector<Batch *> outgoing; // Children waiting to be sent, per owner
+        int num_nodes_generated = 0;
+        int num_nodes_expanded = 0;
+        SearchCounters counters; // The worker thread's search_counters once it is done
+    };
+
+    const Heuristic &heuristic;
+    TieBreak tie_break;
+    vector<Worker> workers;
+
+    atomic<int> incumbent{INT_MAX};
+    mutex goal_lock;
+    int goal_ref = NO_PARENT;
+
+    // Workers that are not idle plus batches sent but not yet taken. Only a busy worker
+    // sends and only a batch wakes an idle one, so once this reaches zero it stays there.
+    atomic<long> outstanding{0};
+    atomic<bool> finished{false};
+
+    int owner_of(State state) const {
+        uint64_t mixed = typename Puzzle::Hash()(state) * 0x9E3779B97F4A7C15ull;
+        return static_cast<int>((mixed >> 32) % workers.size());
+    }
+
+    void work(int self) {
+        Worker &me = workers[self];
+        search_counters = SearchCounters();
+        bool active = true;
+        while (!finished.load(memory_order_acquire)) {
+            receive(me, active);
+            int expansions = 0;
+            while (expansions < EXPANSIONS_PER_POLL && expand_one(self)) {
+                expansions++;
+            }
+            if (expansions > 0) {
+                flush(me);
+            } else if (active) {
+                active = false;
+                if (outstanding.fetch_sub(1) == 1) {
+                    finished.store(true, memory_order_release);
+                }
+            } else {
+                this_thread::yield();
+            }
+        }
+        me.counters = search_counters;
+    }
+
+    void receive(Worker &me, bool &active) {
+        Batch *batch = me.inbox.take_all();
+        while (batch) {
+            if (!active) {
+                outstanding.fetch_add(1);
+                active = true;
+            }
+            for (const Node<Puzzle> &node : batch->nodes) {
+                if (node.g + node.h < incumbent.load(memory_order_relaxed)
+                    && me.context->rank_closed.admit(node.state, node.g)) {
+                    me.context->bucket_open.push(node);
+                }
+            }
+            Batch *next = batch->next;
+            delete batch;
+            outstanding.fetch_sub(1);
+            batch = next;
+        }
+    }
+
+    // Expands the best node below the incumbent; false if there is none.
+    bool expand_one(int self) {
+        Worker &me = workers[self];
+        SearchContext<Puzzle> &context = *me.context;
+        while (!context.bucket_open.empty()) {
+            Node<Puzzle> current = context.bucket_open.pop();
+            if (current.g + current.h >= incumbent.load(memory_order_relaxed)) {
+                continue;
+            }
+            if (!context.rank_closed.close(current.state, current.g)) {
+                continue;
+            }
+            int ref = context.arena.add(current) * static_cast<int>(workers.size()) + self;
+
+            if (current.state == Puzzle::goal) {
+                lock_guard<mutex> guard(goal_lock);
+                if (current.g < incumbent.load()) {
+                    incumbent.store(current.g);
+                    goal_ref = ref;
+                }
+                return true;
+            }
+            me.num_nodes_expanded++;
+
+            Successors<Puzzle> successors = get_successors(current.state, current.h, heuristic);
+            for (int i = 0; i < successors.count; ++i) {
+                Node<Puzzle> child(successors.states[i], current.g + 1, successors.h[i], ref);
+                if (child.g + child.h >= incumbent.load(memory_order_relaxed)) {
+                    continue;
+                }
+                me.num_nodes_generated++;
+                int owner = owner_of(child.state);
+                if (owner == self) {
+                    if (context.rank_closed.admit(child.state, child.g)) {
+                        context.bucket_open.push(child);
+                    }
+                    continue;
+                }
+                Batch *&batch = me.outgoing[owner];
+                if (!batch) {
+                    batch = new Batch();
+                    batch->nodes.reserve(BATCH_SIZE);
+                }
+                batch->nodes.push_back(child);
+                if (batch->nodes.size() == BATCH_SIZE) {
+                    send(owner, batch);
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void send(int owner, Batch *&batch) {
+        outstanding.fetch_add(1);
+        workers[owner].inbox.push(batch);
+        batch = nullptr;
+    }
+
+    void flush(Worker &me) {
+        for (size_t owner = 0; owner < me.outgoing.size(); ++owner) {
+            if (me.outgoing[owner]) {
+                send(static_cast<int>(owner), me.outgoing[owner]);
+            }
+        }
+    }
+};
+
+template <class Heuristic>
+SearchResult<typename Heuristic::Puzzle> hdastar_with(typename Heuristic::State initial_state,
+                                                      const Heuristic &heuristic, const SearchOptions &options) {
+    return HdaStarSearch<Heuristic>(heuristic, options).run(initial_state);
+}
+
+template <class Puzzle>
+SearchResult<Puzzle> hdastar(typename Puzzle::State initial_state, const SearchOptions &options) {
+    return search_with_heuristic<Puzzle>(initial_state, options, [&](const auto &heuristic) {
+        return hdastar_with(initial_state, heuristic, options);
+    });
+}
+
+// Bidirectional A* that meets in the middle (MM). One frontier grows forward from the
+// start, scored by the heuristic toward the goal; the other grows backward from the goal,
+// scored by the Manhattan and corner heuristic toward the start. Each frontier is ordered
+// on max(f, 2g), so neither side expands a node past the midpoint of an optimal path
+// before the other side has reached it.
+//
+// A board reached from both sides closes a path, and the cheapest such path is optimal
+// once its cost U is no more than max(C, fmin_F, fmin_B, gmin_F + gmin_B + 1): C is the
+// smaller of the two frontiers' least priority, fmin and gmin each side's least f and g.
+// Every one of those is a lower bound on any path not yet found.
+template <class ForwardHeuristic, class BackwardHeuristic>
+class BidirectionalSearch {
+public:
+    using Puzzle = typename ForwardHeuristic::Puzzle;
+    using State = typename Puzzle::State;
+
+    BidirectionalSearch(const ForwardHeuristic &forward_heuristic, const BackwardHeuristic &backward_heuristic)
+        : forward_heuristic(forward_heuristic), backward_heuristic(backward_heuristic) {}
+
+    SearchResult<Puzzle> run(State initial_state) {
+        auto start_time = chrono::steady_clock::now();
+
+        Frontier forward, backward;
+        best_cost = INT_MAX;
+        num_nodes_generated = 0;
+        num_nodes_expanded = 0;
+        reach(forward, backward, initial_state, 0, initial_state, forward_heuristic(initial_state));
+        reach(backward, forward, Puzzle::goal, 0, Puzzle::goal, backward_heuristic(Puzzle::goal));
+
+        while (!forward.empty() && !backward.empty()) {
+            int min_priority = min(forward.min_priority(), backward.min_priority());
+            int lower_bound = max({min_priority, forward.min_f(), backward.min_f(), forward.min_g() + backward.min_g() + 1});
+            if (best_cost <= lower_bound) {
+                break;
+            }
+            if (forward.min_priority() <= backward.min_priority()) {
+                expand(forward, backward, forward_heuristic);
+            } else {
+                expand(backward, forward, backward_heuristic);
+            }
+        }
+        if (best_cost == INT_MAX) {
+            return SearchResult<Puzzle>{};
+        }
+
+        vector<State> path;
+        for (State state = meeting; ; state = forward.seen[state].parent) {
+            path.push_back(state);
+            if (state == initial_state) break;
+        }
+        reverse(path.begin(), path.end());
+        for (State state = meeting; state != Puzzle::goal;) {
+            state = backward.seen[state].parent;
+            path.push_back(state);
+        }
+
+        chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+        int depth = path.size() - 1;
+        double branching_factor = effective_branching_factor(num_nodes_generated - 1, depth);
+        return SearchResult<Puzzle>{path, num_nodes_generated, num_nodes_expanded, depth, branching_factor,
+                                    elapsed_time.count(), {}};
+    }
+
+private:
+    struct Entry {
+        State state;
+        int g, h;
+    };
+
+    struct Seen {
+        int g;
+        State parent; // The board this one was reached from; the root names itself
+        bool closed;
+    };
+
+    // One direction's open list, one bucket per priority max(f, 2g), and every board it has
+    // reached. The least f and g on the list are tracked with counts per value; entries
+    // made stale by a cheaper path stay counted until popped, which only makes the
+    // stopping test more cautious.
+    class Frontier {
+    public:
+        unordered_map<State, Seen, typename Puzzle::Hash> seen;
+
+        bool empty() const { return count == 0; }
+
+        void push(const Entry &entry) {
+            int f = entry.g + entry.h;
+            int priority = max(f, 2 * entry.g);
+            grow(buckets, priority);
+            grow(f_counts, f);
+            grow(g_counts, entry.g);
+            buckets[priority].push_back(entry);
+            f_counts[f]++;
+            g_counts[entry.g]++;
+            count++;
+            lowest_priority = min(lowest_priority, priority);
+            lowest_f = min(lowest_f, f);
+            lowest_g = min(lowest_g, entry.g);
+        }
+
+        Entry pop() {
+            min_priority();
+            Entry entry = buckets[lowest_priority].back();
+            buckets[lowest_priority].pop_back();
+            f_counts[entry.g + entry.h]--;
+            g_counts[entry.g]--;
+            count--;
+            return entry;
+        }
+
+        int min_priority() {
+            while (buckets[lowest_priority].empty()) lowest_priority++;
+            return lowest_priority;
+        }
+
+        int min_f() {
+            while (f_counts[lowest_f] == 0) lowest_f++;
+            return lowest_f;
+        }
+
+        int min_g() {
+            while (g_counts[lowest_g] == 0) lowest_g++;
+            return lowest_g;
+        }
+
+    private:
+        vector<vector<Entry>> buckets;
+        vector<int> f_counts, g_counts;
+        int lowest_priority = INT_MAX, lowest_f = INT_MAX, lowest_g = INT_MAX;
+        size_t count = 0;
+
+        template <class T>
+        static void grow(vector<T> &values, int index) {
+            if (index >= static_cast<int>(values.size())) {
+                values.resize(index + 1);
+            }
+        }
+    };
+
+    const ForwardHeuristic &forward_heuristic;
+    const BackwardHeuristic &backward_heuristic;
+    int best_cost = INT_MAX;
+    State meeting = 0;
+    int num_nodes_generated = 0;
+    int num_nodes_expanded = 0;
+
+    // Records a path of cost g to a board on `side` unless a path as cheap is known, and
+    // checks it against the other side's paths to the same board.
+    void reach(Frontier &side, Frontier &other, State state, int g, State parent, int h) {
+        auto inserted = side.seen.emplace(state, Seen{g, parent, false});
+        if (!inserted.second) {
+            if (g >= inserted.first->second.g) {
+                return;
+            }
+            inserted.first->second = Seen{g, parent, false};
+        }
+        side.push(Entry{state, g, h});
+        num_nodes_generated++;
+
+        auto met = other.seen.find(state);
+        if (met != other.seen.end() && g + met->second.g < best_cost) {
+            best_cost = g + met->second.g;
+            meeting = state;
+        }
+    }
+
+    template <class Heuristic>
+    void expand(Frontier &side, Frontier &other, const Heuristic &heuristic) {
+        Entry current = side.pop();
+        Seen &seen = side.seen[current.state];
+        if (seen.closed || current.g > seen.g) {
+            return;
+        }
+        seen.closed = true;
+        num_nodes_expanded++;
+
+        Successors<Puzzle> successors = get_successors(current.state, current.h, heuristic);
+        for (int i = 0; i < successors.count; ++i) {
+            reach(side, other, successors.states[i], current.g + 1, current.state, successors.h[i]);
+        }
+    }
+};
+
+template <class Heuristic>
+SearchResult<typename Heuristic::Puzzle> bidirectional_with(typename Heuristic::State initial_state,
+                                                            const Heuristic &heuristic) {
+    using Puzzle = typename Heuristic::Puzzle;
+    array<int, Puzzle::CELLS> start_tiles;
+    for (int i = 0; i < Puzzle::CELLS; ++i) {
+        start_tiles[i] = Puzzle::tile_at(initial_state, i);
+    }
+    const typename Puzzle::Tables start_tables = make_heuristic_tables<Puzzle::DIMENSION>(start_tiles);
+    ManhattanCornerHeuristic<Puzzle> toward_start{&start_tables};
+    return BidirectionalSearch<Heuristic, ManhattanCornerHeuristic<Puzzle>>(heuristic, toward_start).run(initial_state);
+}
+
+template <class Puzzle>
+SearchResult<Puzzle> bidirectional(typename Puzzle::State initial_state, const SearchOptions &options) {
+    return search_with_heuristic<Puzzle>(initial_state, options, [&](const auto &heuristic) {
+        return bidirectional_with(initial_state, heuristic);
+    });
+}
+
+// Memory-bounded A* in the manner of SMA*: best-first search over a tree of at most as
+// many nodes as the memory budget holds, generating one child at a time. Once memory is
+// full, making room forgets the shallowest of the worst leaves; its parent keeps the
+// forgotten f and goes back on the queue, so the child is generated again only if that f
+// becomes the best on offer. When every child of a node is known, the node's f rises to
+// the least of theirs, which keeps the queue ordered on the best known lower bound.
+//
+// Boards reached along different paths are not merged: memory holds paths, not a closed
+// list. The solution is optimal whenever an optimal path fits in memory; a goal deeper
+// than the budget allows leaves every f at NO_ROOM and the search gives up.
+template <class Heuristic>
+class MemoryBoundedSearch {
+public:
+    using Puzzle = typename Heuristic::Puzzle;
+    using State = typename Puzzle::State;
+
+    MemoryBoundedSearch(const Heuristic &heuristic, size_t memory_budget)
+        : heuristic(heuristic), capacity(max<size_t>(memory_budget / BYTES_PER_NODE, MIN_CAPACITY)) {}
+
+    SearchResult<Puzzle> run(State initial_state) {
+        auto start_time = chrono::steady_clock::now();
+
+        nodes.clear();
+        // Taken whole up front: growing by doubling would briefly hold the old nodes and up to
+        // twice the budget, beyond what BYTES_PER_NODE accounts for
+        nodes.reserve(capacity);
+        free_slots.clear();
+        queue.clear();
+        leaves.clear();
+        num_nodes_generated = 1;
+        num_nodes_expanded = 0;
+
+        int h = heuristic(initial_state);
+        enqueue(allocate(initial_state, 0, h, h, NO_PARENT));
+
+        int goal = NO_PARENT;
+        while (!queue.empty()) {
+            int best = get<2>(*queue.begin());
+            if (nodes[best].f == NO_ROOM) {
+                break;
+            }
+            if (nodes[best].state == Puzzle::goal) {
+                goal = best;
+                break;
+            }
+            generate_next(best);
+        }
+
+        search_counters.forgotten = num_nodes_forgotten;
+        search_counters.regenerated = num_nodes_regenerated;
+        if (goal == NO_PARENT) {
+            return SearchResult<Puzzle>{};
+        }
+
+        vector<State> path;
+        for (int index = goal; index != NO_PARENT; index = nodes[index].parent) {
+            path.push_back(nodes[index].state);
+        }
+        reverse(path.begin(), path.end());
+
+        chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+        int depth = path.size() - 1;
+        double branching_factor = effective_branching_factor(num_nodes_generated - 1, depth);
+        return SearchResult<Puzzle>{path, num_nodes_generated, num_nodes_expanded, depth, branching_factor,
+                                    elapsed_time.count(), {}};
+    }
+
+private:
+    static constexpr int NO_ROOM = INT_MAX; // f of a node whose subtree cannot fit in memory
+    static constexpr int NOT_HELD = -1;     // A child slot with no node in memory
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    struct BoundedNode {
+        State state;
+        int g, h;
+        int f;      // g + h, raised to the least f its children have shown
+        int parent; // NO_PARENT for the root
+        // Children in a fixed order, the move back to the parent left out. Those below
+        // `generated` have been generated at least once; a forgotten one keeps its f.
+        int8_t successors, generated;
+        int8_t held; // Children in memory
+        bool queued;
+        int children[4];
+        int forgotten_f[4];
+    };
+
+    // What a node costs: itself, plus its share of the tree nodes of the two sets below.
+    static constexpr size_t BYTES_PER_NODE = sizeof(BoundedNode) + 96;
+
+    const Heuristic &heuristic;
+    size_t capacity;
+    vector<BoundedNode> nodes;
+    vector<int> free_slots;
+    // (f, -g, index): the front is the best node, deepest first among equal f; the back is
+    // the worst, shallowest first.
+    set<tuple<int, int, int>> queue;
+    set<tuple<int, int, int>> leaves; // The queued nodes that may be forgotten, in the same order
+    int num_nodes_generated = 0;
+    int num_nodes_expanded = 0;
+    long num_nodes_forgotten = 0;
+    long num_nodes_regenerated = 0;
+
+    int allocate(State state, int g, int h, int f, int parent) {
+        BoundedNode node{state, g, h, f, parent, -1, 0, 0, false, {NOT_HELD, NOT_HELD, NOT_HELD, NOT_HELD}, {}};
+        if (!free_slots.empty()) {
+            int index = free_slots.back();
+            free_slots.pop_back();
+            nodes[index] = node;
+            return index;
+        }
+        COUNT(allocations, nodes.size() == nodes.capacity());
+        nodes.push_back(node);
+        return static_cast<int>(nodes.size()) - 1;
+    }
+
+    size_t nodes_held() const { return nodes.size() - free_slots.size(); }
+
+    // Leaves other than the root: they hold no children, so nothing is lost with them but
+    // their own f.
+    static bool forgettable(const BoundedNode &node) {
+        return node.queued && node.held == 0 && node.parent != NO_PARENT;
+    }
+
+    void enqueue(int index) {
+        BoundedNode &node = nodes[index];
+        queue.emplace(node.f, -node.g, index);
+        node.queued = true;
+        if (forgettable(node)) {
+            leaves.emplace(node.f, -node.g, index);
+        }
+    }
+
+    void dequeue(int index) {
+        BoundedNode &node = nodes[index];
+        if (forgettable(node)) {
+            leaves.erase(make_tuple(node.f, -node.g, index));
+        }
+        queue.erase(make_tuple(node.f, -node.g, index));
+        node.queued = false;
+    }
+
+    void hold_child(int index, int slot, int child) {
+        BoundedNode &node = nodes[index];
+        if (forgettable(node)) {
+            leaves.erase(make_tuple(node.f, -node.g, index));
+        }
+        node.children[slot] = child;
+        node.held++;
+    }
+
+    void drop_child(int index, int slot, int f) {
+        BoundedNode &node = nodes[index];
+        node.children[slot] = NOT_HELD;
+        node.forgotten_f[slot] = f;
+        node.held--;
+        if (!node.queued) {
+            enqueue(index);
+        } else if (forgettable(node)) {
+            leaves.emplace(node.f, -node.g, index);
+        }
+    }
+
+    // The node's children, leaving out the board it came from.
+    Successors<Puzzle> children_of(const BoundedNode &node) const {
+        Successors<Puzzle> all = get_successors(node.state, node.h, heuristic);
+        if (node.parent == NO_PARENT) {
+            return all;
+        }
+        Successors<Puzzle> children;
+        for (int i = 0; i < all.count; ++i) {
+            if (all.states[i] != nodes[node.parent].state) {
+                children.states[children.count] = all.states[i];
+                children.h[children.count++] = all.h[i];
+            }
+        }
+        return children;
+    }
+
+    // Adds one child of `index`: the next one never generated, or else the forgotten one
+    // with the least f.
+    void generate_next(int index) {
+        Successors<Puzzle> children = children_of(nodes[index]);
+        int slot;
+        int forgotten_f = 0;
+        {
+            BoundedNode &node = nodes[index];
+            node.successors = children.count;
+            if (node.generated < node.successors) {
+                num_nodes_expanded += node.generated == 0;
+                slot = node.generated++;
+            } else {
+                slot = -1;
+                for (int i = 0; i < node.successors; ++i) {
+                    if (node.children[i] == NOT_HELD && (slot < 0 || node.forgotten_f[i] < node.forgotten_f[slot])) {
+                        slot = i;
+                    }
+                }
+                forgotten_f = node.forgotten_f[slot];
+                num_nodes_regenerated++;
+            }
+        }
+        num_nodes_generated++;
+
+        int g = nodes[index].g + 1;
+        int f = max({nodes[index].f, g + children.h[slot], forgotten_f});
+        // A child on the last level memory can hold has no room for children of its own.
+        if (children.states[slot] != Puzzle::goal && static_cast<size_t>(g) + 1 >= capacity) {
+            f = NO_ROOM;
+        }
+
+        if (nodes_held() >= capacity && !forget_worst_leaf(index)) {
+            nodes[index].forgotten_f[slot] = NO_ROOM;
+            num_nodes_forgotten++;
+        } else {
+            int child = allocate(children.states[slot], g, children.h[slot], f, index);
+            hold_child(index, slot, child);
+            enqueue(child);
+        }
+
+        BoundedNode &node = nodes[index];
+        if (node.generated == node.successors) {
+            // With every child in memory the node has nothing left to offer the queue.
+            if (node.held == node.successors) {
+                dequeue(index);
+            }
+            back_up(index);
+        }
+    }
+
+    // Drops the shallowest leaf of highest f other than `keep` and the root, handing its
+    // f to its parent. False if there is no such leaf.
+    bool forget_worst_leaf(int keep) {
+        for (auto it = leaves.rbegin(); it != leaves.rend(); ++it) {
+            int index = get<2>(*it);
+            if (index == keep) {
+                continue;
+            }
+            int parent = nodes[index].parent;
+            int f = nodes[index].f;
+            dequeue(index);
+            free_slots.push_back(index);
+            num_nodes_forgotten++;
+
+            int slot = 0;
+            while (nodes[parent].children[slot] != index) {
+                slot++;
+            }
+            drop_child(parent, slot, f);
+            return true;
+        }
+        return false;
+    }
+
+    // Raises the f of `index` and its ancestors to the least f among their children, for
+    // as long as every child of theirs has been generated and the least f went up.
+    void back_up(int index) {
+        while (index != NO_PARENT) {
+            BoundedNode &node = nodes[index];
+            if (node.generated < node.successors) {
+                return;
+            }
+            int f = NO_ROOM;
+            for (int slot = 0; slot < node.successors; ++slot) {
+                int child = node.children[slot];
+                f = min(f, child != NOT_HELD ? nodes[child].f : node.forgotten_f[slot]);
+            }
+            if (f <= node.f) {
+                return;
+            }
+            bool queued = node.queued;
+            if (queued) {
+                dequeue(index);
+            }
+            node.f = f;
+            if (queued) {
+                enqueue(index);
+            }
+            index = node.parent;
+        }
+    }
+};
+
+template <class Heuristic>
+SearchResult<typename Heuristic::Puzzle> memory_bounded_with(typename Heuristic::State initial_state,
+                                                             const Heuristic &heuristic, const SearchOptions &options) {
+    return MemoryBoundedSearch<Heuristic>(heuristic, options.memory_budget).run(initial_state);
+}
+
+template <class Puzzle>
+SearchResult<Puzzle> memory_bounded(typename Puzzle::State initial_state, const SearchOptions &options) {
+    return search_with_heuristic<Puzzle>(initial_state, options, [&](const auto &heuristic) {
+        return memory_bounded_with(initial_state, heuristic, options);
+    });
+}
+
+// No search at all: the oracle's path, read off one move at a time.
+SearchResult<EightPuzzle> oracle_solve(EightPuzzle::State initial_state, const DistanceOracle &oracle) {
+    auto start_time = chrono::steady_clock::now();
+    vector<EightPuzzle::State> path = oracle.path(initial_state);
+    if (path.empty()) {
+        return SearchResult<EightPuzzle>{};
+    }
+    chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+    int depth = path.size() - 1;
+    int num_nodes_generated = path.size();
+    double branching_factor = effective_branching_factor(num_nodes_generated - 1, depth);
+    return SearchResult<EightPuzzle>{path, num_nodes_generated, depth, depth, branching_factor,
+                                     elapsed_time.count(), {}};
+}
+
+// The search options.engine names.
+template <class Puzzle>
+SearchResult<Puzzle> run_engine(typename Puzzle::State initial_state, const SearchOptions &options,
+                                SearchContext<Puzzle> &context) {
+    if constexpr (is_same<Puzzle, EightPuzzle>::value) {
+        if (options.engine == SearchEngine::Oracle) {
+            return oracle_solve(initial_state, *options.oracle);
+        }
+    }
+    if (options.engine == SearchEngine::IDAStar) {
+        return idastar(initial_state, options, context);
+    }
+    if (options.engine == SearchEngine::HDAStar) {
+        return hdastar<Puzzle>(initial_state, options);
+    }
+    if (options.engine == SearchEngine::Bidirectional) {
+        return bidirectional<Puzzle>(initial_state, options);
+    }
+    if (options.engine == SearchEngine::MemoryBounded) {
+        return memory_bounded<Puzzle>(initial_state, options);
+    }
+    return astar(initial_state, options, context);
+}
+
+// Runs the engine picked in options, with its counters if they are built in.
+template <class Puzzle>
+SearchResult<Puzzle> solve(typename Puzzle::State initial_state, const SearchOptions &options,
+                           SearchContext<Puzzle> &context) {
+    search_counters = SearchCounters();
+    SearchResult<Puzzle> result = run_engine(initial_state, options, context);
+    result.counters = search_counters;
+    return result;
+}
+
+// How a heuristic compares with the exact distances of the boards nearest the goal.
+struct HeuristicReport {
+    size_t boards = 0;              // Boards whose exact distance is known
+    int depth = 0;                  // Every board within this many moves of the goal is among them
+    size_t overestimates = 0;       // Boards where h exceeds the distance
+    int worst_overestimate = 0;
+    size_t moves = 0;               // Moves out of those boards
+    size_t inconsistent_moves = 0;  // Moves along which h drops by more than one
+    size_t update_mismatches = 0;   // Moves where update() disagrees with scoring the child from scratch
+    double total_h = 0, total_distance = 0;
+};
+
+// Labels boards with their exact distance by breadth-first search back from the goal, a
+// level at a time, stopping once `max_boards` are labelled (the 8-puzzle's whole space
+// fits), and checks the heuristic on every one: admissible if h never exceeds the
+// distance, consistent if no move lowers h by more than its cost of one.
+template <class Heuristic>
+HeuristicReport verify_heuristic(const Heuristic &heuristic, size_t max_boards) {
+    using Puzzle = typename Heuristic::Puzzle;
+    using State = typename Puzzle::State;
+
+    HeuristicReport report;
+    unordered_map<State, int, typename Puzzle::Hash> distance;
+    vector<State> level = {Puzzle::goal};
+    distance[Puzzle::goal] = 0;
+    for (int d = 0; !level.empty(); ++d) {
+        vector<State> next_level;
+        for (State state : level) {
+            int h = heuristic(state);
+            report.boards++;
+            report.total_h += h;
+            report.total_distance += d;
+            if (h > d) {
+                report.overestimates++;
+                report.worst_overestimate = max(report.worst_overestimate, h - d);
+            }
+
+            int blank = Puzzle::blank_pos(state);
+            for (int from : Puzzle::neighbours[blank]) {
+                if (from < 0) continue;
+                State child = Puzzle::move_blank(state, blank, from);
+                int child_h = heuristic(child);
+                report.moves++;
+                if (h - child_h > 1) {
+                    report.inconsistent_moves++;
+                }
+                if (heuristic.update(state, child, h, Puzzle::tile_at(state, from), from, blank) != child_h) {
+                    report.update_mismatches++;
+                }
+                if (distance.emplace(child, d + 1).second) {
+                    next_level.push_back(child);
+                }
+            }
+        }
+        report.depth = d;
+        if (distance.size() >= max_boards) {
+            break;
+        }
+        level.swap(next_level);
+    }
+    return report;
+}
+
+template <class Puzzle>
+HeuristicReport verify_heuristic(const SearchOptions &options, size_t max_boards) {
+    return with_heuristic<Puzzle>(options, [&](const auto &heuristic) {
+        return verify_heuristic(heuristic, max_boards);
+    });
+}
+
+void print_heuristic_report(const HeuristicReport &report) {
+    cout << "Checked " << report.boards << " boards: every board within " << report.depth
+         << " moves of the goal" << endl;
+    cout << "Admissible: ";
+    if (report.overestimates == 0) {
+        cout << "yes" << endl;
+    } else {
+        cout << "no, " << report.overestimates << " boards overestimated, worst by "
+             << report.worst_overestimate << endl;
+    }
+    cout << "Consistent: ";
+    if (report.inconsistent_moves == 0) {
+        cout << "yes" << endl;
+    } else {
+        cout << "no, h drops by more than one along " << report.inconsistent_moves << " of "
+             << report.moves << " moves" << endl;
+    }
+    cout << "Incremental updates: ";
+    if (report.update_mismatches == 0) {
+        cout << "match" << endl;
+    } else {
+        cout << report.update_mismatches << " of " << report.moves << " disagree with scoring from scratch" << endl;
+    }
+    cout << "Mean h / exact distance: " << report.total_h / max(report.total_distance, 1.0) << endl;
+}
+
+// Runs a task for every index of a range on a fixed set of threads. Each worker starts
+// with an equal slice of the range and works through it front to back; a worker whose
+// slice runs dry steals the back half of the largest remaining slice, so uneven tasks
+// still keep every core busy.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int num_workers) : slices(max(num_workers, 1)) {}
+
+    int size() const { return static_cast<int>(slices.size()); }
+
+    // Calls task(index, worker) once for every index in [0, count); returns when all are done.
+    void run(size_t count, const function<void(size_t, int)> &task) {
+        size_t workers = slices.size();
+        for (size_t i = 0; i < workers; ++i) {
+            slices[i].begin = count * i / workers;
+            slices[i].end = count * (i + 1) / workers;
+        }
+        vector<thread> threads;
+        for (size_t i = 0; i < workers; ++i) {
+            threads.emplace_back([this, &task, i] {
+                size_t index;
+                while (take(i, index) || steal(i, index)) {
+                    task(index, static_cast<int>(i));
+                }
+            });
+        }
+        for (thread &worker : threads) {
+            worker.join();
+        }
+    }
+
+private:
+    struct Slice {
+        mutex lock;
+        size_t begin = 0, end = 0;
+    };
+
+    vector<Slice> slices;
+
+    bool take(size_t worker, size_t &index) {
+        Slice &slice = slices[worker];
+        lock_guard<mutex> guard(slice.lock);
+        if (slice.begin == slice.end) {
+            return false;
+        }
+        index = slice.begin++;
+        return true;
+    }
+
+    bool steal(size_t thief, size_t &index) {
+        while (true) {
+            size_t victim = thief;
+            size_t most = 0;
+            for (size_t i = 0; i < slices.size(); ++i) {
+                lock_guard<mutex> guard(slices[i].lock);
+                if (slices[i].end - slices[i].begin > most) {
+                    most = slices[i].end - slices[i].begin;
+                    victim = i;
+                }
+            }
+            if (most == 0) {
+                return false;
+            }
+            size_t begin, end;
+            {
+                lock_guard<mutex> guard(slices[victim].lock);
+                if (slices[victim].begin == slices[victim].end) {
+                    continue; // Emptied since we looked; pick again
+                }
+                end = slices[victim].end;
+                begin = slices[victim].begin + (end - slices[victim].begin) / 2;
+                slices[victim].end = begin;
+            }
+            lock_guard<mutex> guard(slices[thief].lock);
+            slices[thief].begin = begin + 1;
+            slices[thief].end = end;
+            index = begin;
+            return true;
+        }
+    }
+};
+
+// Reads a board written either as one digit per cell ("283164075", boards up to 3x3 only)
+// or as tiles separated by spaces or commas. False unless it holds each tile exactly once.
+template <class Puzzle>
+bool parse_board(const string &line, typename Puzzle::State &state) {
+    vector<int> tiles;
+    bool separated = line.find_first_of(" ,\t") != string::npos;
+    int value = -1;
+    for (char c : line) {
+        if (c >= '0' && c <= '9') {
+            if (!separated) {
+                tiles.push_back(c - '0');
+            } else {
+                // Already too big for a tile: stop before a long digit run overflows
+                if (value >= Puzzle::CELLS) return false;
+                value = (value < 0 ? 0 : value * 10) + (c - '0');
+            }
+        } else if (c == ' ' || c == ',' || c == '\t' || c == '\r') {
+            if (value >= 0) tiles.push_back(value);
+            value = -1;
+        } else {
+            return false;
+        }
+    }
+    if (value >= 0) tiles.push_back(value);
+
+    unsigned seen = 0;
+    for (int tile : tiles) {
+        if (tile >= Puzzle::CELLS || (seen & (1u << tile))) return false;
+        seen |= 1u << tile;
+    }
+    if (tiles.size() != Puzzle::CELLS) {
+        return false;
+    }
+    state = Puzzle::pack(tiles);
+    return true;
+}
+
+// A board in the form parse_board() reads: digits while every tile is one, else comma-separated.
+template <class Puzzle>
+string board_to_string(typename Puzzle::State state) {
+    string text;
+    for (int i = 0; i < Puzzle::CELLS; ++i) {
+        if (Puzzle::CELLS > 10 && i > 0) {
+            text += ',';
+        }
+        text += to_string(Puzzle::tile_at(state, i));
+    }
+    return text;
+}
+
+// How results are written: Text is the full report for a single board and
+//     <board> <moves> <nodes generated> <nodes expanded> <seconds>
+// per board in batch mode; Csv and Json give one machine-readable line per board; Path
+// gives "<board> <moves>" followed by every board on the solution; Binary writes a
+// result file (see ResultRecord); Silent writes nothing.
+enum class OutputFormat { Text, Csv, Json, Path, Binary, Silent };
+
+enum class ResultStatus { Invalid, Unsolvable, Unsolved, Solved };
+
+const char *status_name(ResultStatus status) {
+    switch (status) {
+    case ResultStatus::Invalid: return "invalid";
+    case ResultStatus::Unsolvable: return "unsolvable";
+    case ResultStatus::Unsolved: return "unsolved";
+    default: return "solved";
+    }
+}
+
+// One line per solve in an OutputFormat other than the single-board report. Lines collect
+// in a buffer that is handed to the stream only when it passes FLUSH_SIZE or on flush(),
+// so a batch pays for a write every few thousand boards rather than every board.
+template <class Puzzle>
+class ResultSink {
+public:
+    ResultSink(ostream &out, OutputFormat format) : out(out), format(format) {}
+    ~ResultSink() { flush(); }
+
+    // `board` is the board as written back (the input line itself when it was invalid).
+    void write(const string &board, ResultStatus status, const SearchResult<Puzzle> &result) {
+        switch (format) {
+        case OutputFormat::Text:
+            buffer += board;
+            if (status == ResultStatus::Solved) {
+                buffer += ' ' + to_string(result.depth) + ' ' + to_string(result.num_nodes_generated) + ' '
+                          + to_string(result.num_nodes_expanded) + ' ' + seconds(result.execution_time);
+            } else {
+                buffer += ' ' + string(status_name(status));
+            }
+            break;
+        case OutputFormat::Csv:
+            if (!header_written) {
+                buffer += "board,status,moves,nodes_generated,nodes_expanded,seconds\n";
+                header_written = true;
+            }
+            buffer += csv_field(board);
+            buffer += ',' + string(status_name(status));
+            if (status == ResultStatus::Solved) {
+                buffer += ',' + to_string(result.depth) + ',' + to_string(result.num_nodes_generated) + ','
+                          + to_string(result.num_nodes_expanded) + ',' + seconds(result.execution_time);
+            } else {
+                buffer += ",,,,";
+            }
+            break;
+        case OutputFormat::Json:
+            buffer += "{\"board\":\"" + json_string(board) + "\",\"status\":\"" + status_name(status) + '"';
+            if (status == ResultStatus::Solved) {
+                buffer += ",\"moves\":" + to_string(result.depth)
+                          + ",\"nodes_generated\":" + to_string(result.num_nodes_generated)
+                          + ",\"nodes_expanded\":" + to_string(result.num_nodes_expanded)
+                          + ",\"seconds\":" + seconds(result.execution_time);
+                if (result.counters.forgotten > 0) {
+                    buffer += ",\"forgotten\":" + to_string(result.counters.forgotten)
+                              + ",\"regenerated\":" + to_string(result.counters.regenerated);
+                }
+#if SEARCH_COUNTERS
+                const SearchCounters &counters = result.counters;
+                buffer += ",\"counters\":{\"open_pushes\":" + to_string(counters.open_pushes)
+                          + ",\"open_pops\":" + to_string(counters.open_pops)
+                          + ",\"open_duplicates\":" + to_string(counters.open_duplicates)
+                          + ",\"closed_duplicates\":" + to_string(counters.closed_duplicates)
+                          + ",\"reopenings\":" + to_string(counters.reopenings)
+                          + ",\"stale_pops\":" + to_string(counters.stale_pops)
+                          + ",\"heuristic_updates\":" + to_string(counters.heuristic_updates)
+                          + ",\"heuristic_seconds\":" + seconds(counters.heuristic_seconds)
+                          + ",\"allocations\":" + to_string(counters.allocations)
+                          + ",\"peak_open\":" + to_string(counters.peak_open)
+                          + ",\"peak_closed\":" + to_string(counters.peak_closed) + '}';
+#endif
+            }
+            buffer += '}';
+            break;
+        case OutputFormat::Path:
+            buffer += board;
+            if (status == ResultStatus::Solved) {
+                buffer += ' ' + to_string(result.depth);
+                for (typename Puzzle::State state : result.path) {
+                    buffer += ' ' + board_to_string<Puzzle>(state);
+                }
+            } else {
+                buffer += ' ' + string(status_name(status));
+            }
+            break;
+        case OutputFormat::Binary: // Written by BinaryResultWriter instead
+        case OutputFormat::Silent:
+            return;
+        }
+        buffer += '\n';
+        if (buffer.size() >= FLUSH_SIZE) {
+            flush();
+        }
+    }
+
+    void flush() {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+
+private:
+    static const size_t FLUSH_SIZE = 1 << 16;
+
+    ostream &out;
+    OutputFormat format;
+    string buffer;
+    bool header_written = false;
+
+    // Invalid lines are written back as read, so they may hold anything.
+    static string csv_field(const string &text) {
+        if (text.find_first_of(",\"\r\n") == string::npos) {
+            return text;
+        }
+        string field = "\"";
+        for (char c : text) {
+            field += c == '"' ? string("\"\"") : string(1, c);
+        }
+        return field + '"';
+    }
+
+    static string json_string(const string &text) {
+        string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", c);
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    // Seconds as the stream would print them, six significant digits.
+    static string seconds(double value) {
+        char text[32];
+        snprintf(text, sizeof(text), "%g", value);
+        return text;
+    }
+};
+
+// Binary batch files, for feeding millions of boards through without parsing or printing.
+// A board file is a BoardFileHeader and then `count` boards stored exactly as
+// Puzzle::State, so a mapped file is searched in place. A result file is a
+// ResultFileHeader and then, per board in input order, a ResultRecord followed by its
+// moves packed four to a byte (MOVE_LETTERS order, lowest bits first) and padded to a
+// multiple of 8 bytes. Both are in host byte order.
+struct BoardFileHeader {
+    char magic[8];        // "8PUZBRD"
+    uint32_t version;
+    uint32_t dimension;
+    uint32_t record_size; // sizeof(Puzzle::State)
+    uint32_t reserved;
+    uint64_t count;       // Boards that follow; 32 bytes in all keep 5x5 boards 16-byte aligned
+};
+
+struct ResultFileHeader {
+    char magic[8];        // "8PUZRES"
+    uint32_t version;
+    uint32_t dimension;
+    uint32_t record_size; // sizeof(ResultRecord)
+    uint32_t reserved;
+};
+
+struct ResultRecord {
+    uint64_t board_low, board_high;
+    uint8_t status;       // ResultStatus
+    uint8_t reserved;
+    uint16_t moves;       // Solution length if solved, input line length if invalid, else 0
+    uint32_t nodes_generated;
+    uint32_t nodes_expanded;
+    float seconds;
+};
+
+static_assert(sizeof(BoardFileHeader) == 32 && sizeof(ResultRecord) == 32, "binary records are fixed-size");
+
+const char BOARD_FILE_MAGIC[8] = {'8', 'P', 'U', 'Z', 'B', 'R', 'D', '\0'};
+const char RESULT_FILE_MAGIC[8] = {'8', 'P', 'U', 'Z', 'R', 'E', 'S', '\0'};
+const uint32_t RESULT_FILE_VERSION = 2; // 2: invalid records carry their input line
+
+// The way the blank moves on each step: up, down, left or right.
+const char MOVE_LETTERS[] = "UDLR";
+
+template <class Puzzle>
+string solution_moves(const vector<typename Puzzle::State> &path) {
+    string moves;
+    for (size_t i = 1; i < path.size(); ++i) {
+        int step = Puzzle::blank_pos(path[i]) - Puzzle::blank_pos(path[i - 1]);
+        moves += step == -Puzzle::DIMENSION ? 'U' : step == Puzzle::DIMENSION ? 'D' : step == -1 ? 'L' : 'R';
+    }
+    return moves;
+}
+
+// True if `state` holds each tile exactly once and is packed as Puzzle::pack() would.
+template <class Puzzle>
+bool is_valid_board(typename Puzzle::State state) {
+    array<int, Puzzle::CELLS> tiles;
+    unsigned seen = 0;
+    for (int cell = 0; cell < Puzzle::CELLS; ++cell) {
+        tiles[cell] = Puzzle::tile_at(state, cell);
+        if (tiles[cell] >= Puzzle::CELLS || (seen & (1u << tiles[cell]))) {
+            return false;
+        }
+        seen |= 1u << tiles[cell];
+    }
+    return state == pack_tiles<Puzzle::DIMENSION>(tiles);
+}
+
+// The boards of a mapped board file, read in place; nullptr unless it is a whole board
+// file for this puzzle.
+template <class Puzzle>
+const typename Puzzle::State *board_file_boards(const MappedFile &file, size_t &count) {
+    if (file.size() < sizeof(BoardFileHeader) || !file.starts_with(BOARD_FILE_MAGIC)) {
+        return nullptr;
+    }
+    BoardFileHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.version != 1 || header.dimension != Puzzle::DIMENSION
+        || header.record_size != sizeof(typename Puzzle::State)
+        || header.count > (file.size() - sizeof(header)) / sizeof(typename Puzzle::State)) {
+        return nullptr;
+    }
+    count = header.count;
+    return reinterpret_cast<const typename Puzzle::State *>(file.data() + sizeof(header));
+}
+
+// Writes a board file: the header, then the boards as they are held in memory.
+template <class Puzzle>
+bool write_board_file(const string &path, const vector<typename Puzzle::State> &boards) {
+    BoardFileHeader header = {};
+    memcpy(header.magic, BOARD_FILE_MAGIC, sizeof(header.magic));
+    header.version = 1;
+    header.dimension = Puzzle::DIMENSION;
+    header.record_size = sizeof(typename Puzzle::State);
+    header.count = boards.size();
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(boards.data()),
+              static_cast<streamsize>(boards.size() * sizeof(typename Puzzle::State)));
+    return static_cast<bool>(out);
+}
+
+// The result file counterpart of ResultSink: records collect in a buffer that goes to the
+// stream in blocks of FLUSH_SIZE.
+template <class Puzzle>
+class BinaryResultWriter {
+public:
+    explicit BinaryResultWriter(ostream &out) : out(out) {
+        ResultFileHeader header = {};
+        memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic));
+        header.version = RESULT_FILE_VERSION;
+        header.dimension = Puzzle::DIMENSION;
+        header.record_size = sizeof(ResultRecord);
+        append(&header, sizeof(header));
+    }
+    ~BinaryResultWriter() { flush(); }
+
+    void write(typename Puzzle::State board, ResultStatus status, const SearchResult<Puzzle> &result) {
+        unsigned __int128 packed = board;
+        bool solved = status == ResultStatus::Solved;
+        ResultRecord record = {static_cast<uint64_t>(packed), static_cast<uint64_t>(packed >> 64),
+                               static_cast<uint8_t>(status), 0,
+                               static_cast<uint16_t>(solved ? result.depth : 0),
+                               static_cast<uint32_t>(solved ? result.num_nodes_generated : 0),
+                               static_cast<uint32_t>(solved ? result.num_nodes_expanded : 0),
+                               static_cast<float>(solved ? result.execution_time : 0)};
+        append(&record, sizeof(record));
+        if (solved) {
+            string moves = solution_moves<Puzzle>(result.path);
+            size_t first = buffer.size();
+            buffer.resize(first + packed_moves_size(moves.size()));
+            for (size_t i = 0; i < moves.size(); ++i) {
+                int code = static_cast<int>(strchr(MOVE_LETTERS, moves[i]) - MOVE_LETTERS);
+                buffer[first + i / 4] |= static_cast<char>(code << (2 * (i % 4)));
+            }
+        }
+        if (buffer.size() >= FLUSH_SIZE) {
+            flush();
+        }
+    }
+
+    // A line that is not a board: an Invalid record with no board, followed by the line
+    // itself (up to 65535 bytes) padded to 8 bytes, so --to-text prints what the text
+    // writer would have.
+    void write_invalid(const string &line) {
+        size_t length = min<size_t>(line.size(), UINT16_MAX);
+        ResultRecord record = {0, 0, static_cast<uint8_t>(ResultStatus::Invalid), 0, static_cast<uint16_t>(length),
+                               0, 0, 0};
+        append(&record, sizeof(record));
+        append(line.data(), length);
+        buffer.resize(buffer.size() + packed_text_size(length) - length);
+        if (buffer.size() >= FLUSH_SIZE) {
+            flush();
+        }
+    }
+
+    void flush() {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+
+    // Bytes of packed moves after a record, padding included.
+    static size_t packed_moves_size(size_t moves) { return (moves + 31) / 32 * 8; }
+
+    // Bytes of input line after an invalid record, padding included.
+    static size_t packed_text_size(size_t length) { return (length + 7) / 8 * 8; }
+
+private:
+    static const size_t FLUSH_SIZE = 1 << 20;
+
+    ostream &out;
+    string buffer;
+
+    void append(const void *data, size_t size) { buffer.append(static_cast<const char *>(data), size); }
+};
+
+// Solves boards[0, count) on `num_threads` workers, each with its own SearchContext, and
+// writes the results to `out` in input order: a result file when `format` is Binary, else
+// through a ResultSink with the board written as board_text(i). Boards not marked valid
+// are not searched, nor are those that parity rules out. The writer is woken once per
+// WAKE_EVERY finished boards rather than per board, so quick solves are not paced by
+// thread switches.
+template <class Puzzle, class BoardText>
+void solve_in_order(const typename Puzzle::State *boards, size_t count, const vector<char> &valid,
+                    BoardText board_text, ostream &out, const SearchOptions &options, int num_threads,
+                    OutputFormat format) {
+    vector<char> solvable(count);
+    for (size_t i = 0; i < count; ++i) {
+        solvable[i] = valid[i] && is_solvable<Puzzle>(boards[i]);
+    }
+
+    WorkStealingPool pool(num_threads);
+    vector<unique_ptr<SearchContext<Puzzle>>> contexts;
+    for (int i = 0; i < pool.size(); ++i) {
+        contexts.emplace_back(new SearchContext<Puzzle>());
+    }
+
+    vector<SearchResult<Puzzle>> results(count);
+    const size_t WAKE_EVERY = 256;
+    vector<char> done(count, false);
+    size_t num_done = 0;
+    mutex done_lock;
+    condition_variable done_changed;
+
+    thread writer([&] {
+        unique_ptr<BinaryResultWriter<Puzzle>> binary;
+        unique_ptr<ResultSink<Puzzle>> sink;
+        if (format == OutputFormat::Binary) {
+            binary.reset(new BinaryResultWriter<Puzzle>(out));
+        } else {
+            sink.reset(new ResultSink<Puzzle>(out, format));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            {
+                unique_lock<mutex> guard(done_lock);
+                done_changed.wait(guard, [&] {
+                    return done[i] && (num_done >= i + WAKE_EVERY || num_done == count);
+                });
+            }
+            const SearchResult<Puzzle> &result = results[i];
+            ResultStatus status = !valid[i]             ? ResultStatus::Invalid
+                                  : !solvable[i]        ? ResultStatus::Unsolvable
+                                  : result.path.empty() ? ResultStatus::Unsolved
+                                                        : ResultStatus::Solved;
+            if (binary && status == ResultStatus::Invalid) {
+                binary->write_invalid(board_text(i));
+            } else if (binary) {
+                binary->write(boards[i], status, result);
+            } else {
+                sink->write(board_text(i), status, result);
+            }
+            results[i] = SearchResult<Puzzle>(); // Drop the path once it has been written
+        }
+    });
+
+    pool.run(count, [&](size_t index, int worker) {
+        SearchResult<Puzzle> result;
+        if (solvable[index]) {
+            result = solve(boards[index], options, *contexts[worker]);
+        }
+        lock_guard<mutex> guard(done_lock);
+        results[index] = move(result);
+        done[index] = true;
+        if (++num_done % WAKE_EVERY == 0 || num_done == count) {
+            done_changed.notify_one();
+        }
+    });
+    writer.join();
+}
+
+// Reads boards from `in` as text (one per line; blank lines and lines starting with '#'
+// are skipped) and solves them with solve_in_order(). In Text format each gets one line:
+//     <board> <moves> <nodes generated> <nodes expanded> <seconds>
+// or "<line> invalid" / "<board> unsolvable" (rejected by parity, never searched) /
+// "<board> unsolved".
+template <class Puzzle>
+void solve_batch(istream &in, ostream &out, const SearchOptions &options, int num_threads, OutputFormat format) {
+    vector<string> lines;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        lines.push_back(line);
+    }
+
+    vector<typename Puzzle::State> boards(lines.size());
+    vector<char> valid(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        valid[i] = parse_board<Puzzle>(lines[i], boards[i]);
+    }
+    solve_in_order<Puzzle>(
+        boards.data(), boards.size(), valid,
+        [&](size_t i) { return valid[i] ? board_to_string<Puzzle>(boards[i]) : lines[i]; }, out, options,
+        num_threads, format);
+}
+
+// Solves the boards of a mapped board file with solve_in_order(), straight from the mapping.
+template <class Puzzle>
+void solve_board_file(const typename Puzzle::State *boards, size_t count, ostream &out,
+                      const SearchOptions &options, int num_threads, OutputFormat format) {
+    vector<char> valid(count);
+    for (size_t i = 0; i < count; ++i) {
+        valid[i] = is_valid_board<Puzzle>(boards[i]);
+    }
+    solve_in_order<Puzzle>(
+        boards, count, valid, [&](size_t i) { return board_to_string<Puzzle>(boards[i]); }, out, options,
+        num_threads, format);
+}
+
+// --to-binary: boards read as text from `in` (as solve_batch() reads them) are written to
+// a board file. Lines that are not boards are counted and left out.
+template <class Puzzle>
+int convert_to_board_file(istream &in, const string &path) {
+    vector<typename Puzzle::State> boards;
+    size_t skipped = 0;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        typename Puzzle::State state;
+        if (parse_board<Puzzle>(line, state)) {
+            boards.push_back(state);
+        } else {
+            skipped++;
+        }
+    }
+    if (skipped > 0) {
+        cerr << "Left out " << skipped << " lines that are not " << Puzzle::DIMENSION << "x" << Puzzle::DIMENSION
+             << " boards" << endl;
+    }
+    if (!write_board_file<Puzzle>(path, boards)) {
+        cerr << "Could not write " << path << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// --to-text: a board file back to one board per line, or a result file to one line per
+// board: "<board> <moves> <move letters> <nodes generated> <nodes expanded> <seconds>"
+// (the letters are "-" for a board already solved), or "<board> <status>" for a board
+// that was not solved.
+template <class Puzzle>
+int convert_to_text(const string &path, ostream &out) {
+    MappedFile file(path);
+    string text;
+    if (file.starts_with(BOARD_FILE_MAGIC)) {
+        size_t count = 0;
+        const typename Puzzle::State *boards = board_file_boards<Puzzle>(file, count);
+        if (!boards) {
+            cerr << path << " is not a complete board file for " << Puzzle::DIMENSION << "x" << Puzzle::DIMENSION
+                 << " boards" << endl;
+            return 1;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            text += board_to_string<Puzzle>(boards[i]) + '\n';
+            if (text.size() >= (1 << 20)) {
+                out.write(text.data(), text.size());
+                text.clear();
+            }
+        }
+        out.write(text.data(), text.size());
+        return out ? 0 : 1;
+    }
+
+    ResultFileHeader header;
+    if (!file.starts_with(RESULT_FILE_MAGIC) || file.size() < sizeof(header)) {
+        cerr << path << " is neither a board file nor a result file" << endl;
+        return 1;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.version != RESULT_FILE_VERSION || header.dimension != Puzzle::DIMENSION
+        || header.record_size != sizeof(ResultRecord)) {
+        cerr << path << " does not hold " << Puzzle::DIMENSION << "x" << Puzzle::DIMENSION << " results" << endl;
+        return 1;
+    }
+    size_t offset = sizeof(header);
+    size_t records = 0;
+    while (offset + sizeof(ResultRecord) <= file.size()) {
+        ResultRecord record;
+        memcpy(&record, file.data() + offset, sizeof(record));
+        ResultStatus status = static_cast<ResultStatus>(record.status);
+        size_t moves_size = status == ResultStatus::Invalid
+                                ? BinaryResultWriter<Puzzle>::packed_text_size(record.moves)
+                                : BinaryResultWriter<Puzzle>::packed_moves_size(record.moves);
+        if (offset + sizeof(record) + moves_size > file.size()
+            || record.status > static_cast<uint8_t>(ResultStatus::Solved)) {
+            break;
+        }
+        offset += sizeof(record);
+        records++;
+        if (status == ResultStatus::Invalid) {
+            text.append(reinterpret_cast<const char *>(file.data()) + offset, record.moves);
+        } else {
+            unsigned __int128 packed = (static_cast<unsigned __int128>(record.board_high) << 64) | record.board_low;
+            text += board_to_string<Puzzle>(static_cast<typename Puzzle::State>(packed));
+        }
+        if (status == ResultStatus::Solved) {
+            text += ' ' + to_string(record.moves) + ' ';
+            if (record.moves == 0) {
+                text += '-';
+            }
+            for (int i = 0; i < record.moves; ++i) {
+                text += MOVE_LETTERS[(file.data()[offset + i / 4] >> (2 * (i % 4))) & 3];
+            }
+            char stats[64];
+            snprintf(stats, sizeof(stats), " %u %u %g", record.nodes_generated, record.nodes_expanded, record.seconds);
+            text += stats;
+        } else {
+            text += ' ' + string(status_name(status));
+        }
+        text += '\n';
+        offset += moves_size;
+        if (text.size() >= (1 << 20)) {
+            out.write(text.data(), text.size());
+            text.clear();
+        }
+    }
+    out.write(text.data(), text.size());
+    if (offset != file.size()) {
+        cerr << path << ": record " << records + 1 << " is damaged or cut short" << endl;
+        return 1;
+    }
+    return out ? 0 : 1;
+}
+
+// Optimal distances and first moves of boards already solved, evicting the least recently
+// used once `capacity` boards are held. Every board on a solution path is a solved board
+// in its own right, so one search fills in a whole chain down to the goal.
+template <class Puzzle>
+class SolutionCache {
+public:
+    using State = typename Puzzle::State;
+
+    explicit SolutionCache(size_t capacity) : capacity(capacity) {}
+
+    size_t size() const { return entries.size(); }
+
+    // Records every board on an optimal path to the goal.
+    void insert(const vector<State> &path) {
+        for (size_t i = 0; i < path.size(); ++i) {
+            int distance = static_cast<int>(path.size() - 1 - i);
+            int next_blank = i + 1 < path.size() ? Puzzle::blank_pos(path[i + 1]) : -1;
+            auto found = index.find(path[i]);
+            if (found != index.end()) {
+                entries.splice(entries.begin(), entries, found->second);
+                continue;
+            }
+            entries.push_front(Entry{path[i], static_cast<int16_t>(distance), static_cast<int8_t>(next_blank)});
+            index.emplace(path[i], entries.begin());
+            if (entries.size() > capacity) {
+                index.erase(entries.back().state);
+                entries.pop_back();
+            }
+        }
+    }
+
+    // The optimal path from `state` read off the cache one move at a time, or an empty path
+    // if the board, or any board after it, is not held.
+    vector<State> path(State state) {
+        vector<State> path;
+        while (true) {
+            auto found = index.find(state);
+            if (found == index.end()) {
+                return vector<State>();
+            }
+            entries.splice(entries.begin(), entries, found->second);
+            const Entry &entry = *found->second;
+            path.push_back(state);
+            if (entry.distance == 0) {
+                return path;
+            }
+            state = Puzzle::move_blank(state, Puzzle::blank_pos(state), entry.next_blank);
+        }
+    }
+
+private:
+    struct Entry {
+        State state;
+        int16_t distance;
+        int8_t next_blank; // The cell the blank moves to on the first optimal move, -1 at the goal
+    };
+
+    size_t capacity;
+    list<Entry> entries; // Most recently used first
+    unordered_map<State, typename list<Entry>::iterator, typename Puzzle::Hash> index;
+};
+
+// A solver kept alive across queries: the heuristic tables in `options` are built once by
+// the caller, the search context stays warm, and solved boards are answered from the
+// cache without searching.
+template <class Puzzle>
+class Solver {
+public:
+    using State = typename Puzzle::State;
+
+    Solver(const SearchOptions &options, size_t cache_capacity) : options(options), cache(cache_capacity) {}
+
+    // Solves an already-validated board; `cached` reports whether the cache answered it.
+    SearchResult<Puzzle> solve(State state, bool &cached) {
+        auto start_time = chrono::steady_clock::now();
+        vector<State> path = cache.path(state);
+        cached = !path.empty();
+        if (cached) {
+            hits++;
+            chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+            int depth = path.size() - 1;
+            return SearchResult<Puzzle>{path, 0, 0, depth, 0, elapsed_time.count(), {}};
+        }
+        misses++;
+        SearchResult<Puzzle> result = ::solve(state, options, context);
+        cache.insert(result.path);
+        return result;
+    }
+
+    size_t cache_hits() const { return hits; }
+    size_t cache_misses() const { return misses; }
+    size_t cache_size() const { return cache.size(); }
+
+private:
+    SearchOptions options;
+    SearchContext<Puzzle> context;
+    SolutionCache<Puzzle> cache;
+    size_t hits = 0, misses = 0;
+};
+
+// Answers one query line in `format`, the same line batch mode would write for it.
+template <class Puzzle>
+void answer_query(const string &line, Solver<Puzzle> &solver, ResultSink<Puzzle> &sink) {
+    typename Puzzle::State state;
+    if (!parse_board<Puzzle>(line, state)) {
+        sink.write(line, ResultStatus::Invalid, SearchResult<Puzzle>());
+    } else if (!is_solvable<Puzzle>(state)) {
+        sink.write(board_to_string<Puzzle>(state), ResultStatus::Unsolvable, SearchResult<Puzzle>());
+    } else {
+        bool cached;
+        SearchResult<Puzzle> result = solver.solve(state, cached);
+        sink.write(board_to_string<Puzzle>(state), result.path.empty() ? ResultStatus::Unsolved : ResultStatus::Solved,
+                   result);
+    }
+    sink.flush();
+}
+
+// Reads queries from `in` one per line, answering each as soon as it is read; blank lines
+// and lines starting with '#' are skipped.
+template <class Puzzle>
+void serve_stream(istream &in, ostream &out, Solver<Puzzle> &solver, OutputFormat format) {
+    ResultSink<Puzzle> sink(out, format);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        answer_query(line, solver, sink);
+    }
+}
+
+// Serves the same line protocol on a Unix socket at `path`, one client at a time, until
+// the process is killed. A socket left at `path` by an earlier run is replaced; anything
+// else there is left alone. False if the socket cannot be set up.
+template <class Puzzle>
+bool serve_socket(const string &path, Solver<Puzzle> &solver, OutputFormat format) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    strcpy(address.sun_path, path.c_str());
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            cerr << path << " exists and is not a socket" << endl;
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return false;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        close(listener);
+        return false;
+    }
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        ostringstream replies;
+        ResultSink<Puzzle> sink(replies, format);
+        string pending;
+        char chunk[4096];
+        ssize_t received;
+        while ((received = read(client, chunk, sizeof(chunk))) > 0) {
+            pending.append(chunk, received);
+            size_t start = 0, end;
+            while ((end = pending.find('\n', start)) != string::npos) {
+                string line = pending.substr(start, end - start);
+                start = end + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty() || line[0] == '#') continue;
+                answer_query(line, solver, sink);
+                string reply = replies.str();
+                replies.str("");
+                if (send(client, reply.data(), reply.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(reply.size())) {
+                    received = 0;
+                    break;
+                }
+            }
+            pending.erase(0, start);
+            if (received == 0) break;
+        }
+        close(client);
+    }
+}
+
+template <class Puzzle>
+int serve(const SearchOptions &options, const string &socket_path, size_t cache_capacity, OutputFormat format) {
+    Solver<Puzzle> solver(options, cache_capacity);
+    if (socket_path.empty()) {
+        serve_stream(cin, cout, solver, format);
+        cerr << "Answered " << solver.cache_hits() + solver.cache_misses() << " queries, " << solver.cache_hits()
+             << " from the cache (" << solver.cache_size() << " boards held)" << endl;
+        return 0;
+    }
+    if (!serve_socket(socket_path, solver, format)) {
+        cerr << "Could not listen on " << socket_path << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Settings for --bench. The corpus is fixed by the seed, so two runs with the same
+// settings time exactly the same boards.
+struct BenchOptions {
+    uint64_t seed = 1;
+    int per_bucket = 10;     // Boards wanted for each band of optimal depths
+    int warmup = 1;          // Untimed solves of each board before the timed ones
+    int repeat = 5;          // Timed solves of each board
+    double tolerance = 0.10; // Allowed slowdown against the baseline before failing
+    string engines;          // Comma-separated engines to run, all of them when empty
+    string heuristics;       // Comma-separated heuristics to run, all of them when empty
+    string baseline_path;    // Compare against this baseline
+    string save_path;        // Write the results here as the next baseline
+};
+
+// Boards are grouped by optimal depth in bands this many moves wide.
+const int BENCH_BAND = 5;
+
+// Differences in p50 below this many seconds are timer noise, never a regression.
+const double BENCH_NOISE_FLOOR = 20e-6;
+
+template <class Puzzle>
+struct BenchBoard {
+    typename Puzzle::State state;
+    int depth; // Optimal number of moves
+};
+
+// The deepest boards the corpus reaches for: every 8-puzzle depth, and on the larger
+// boards as deep as the weakest engine still finishes in seconds.
+template <class Puzzle>
+constexpr int bench_max_depth() {
+    return Puzzle::DIMENSION == 3 ? 31 : Puzzle::DIMENSION == 4 ? 35 : 25;
+}
+
+// Seeded random solvable boards, up to per_bucket of them in each band of optimal depths.
+// Each board is a random walk from the goal (no move straight back) of a random length,
+// so every depth is reachable, and is then solved optimally to learn its depth. Bands
+// that random walks rarely land in (the very deepest 8-puzzle boards) may stay short.
+template <class Puzzle>
+vector<BenchBoard<Puzzle>> make_bench_corpus(const BenchOptions &bench) {
+    using State = typename Puzzle::State;
+    const int max_depth = bench_max_depth<Puzzle>();
+    const int bands = max_depth / BENCH_BAND + 1;
+    mt19937_64 random(bench.seed);
+    SearchOptions exact;
+    exact.engine = Puzzle::DIMENSION == 3 ? SearchEngine::AStar : SearchEngine::IDAStar;
+    SearchContext<Puzzle> context;
+
+    vector<vector<BenchBoard<Puzzle>>> by_band(bands);
+    int missing = bands * bench.per_bucket;
+    for (long attempt = 0; missing > 0 && attempt < 100L * bands * bench.per_bucket; ++attempt) {
+        State state = Puzzle::goal;
+        int blank = Puzzle::blank_pos(state), previous = -1;
+        int length = 1 + random() % (Puzzle::DIMENSION == 3 ? 2 * max_depth : max_depth + max_depth / 2);
+        for (int step = 0; step < length; ++step) {
+            int choices[4], count = 0;
+            for (int to : Puzzle::neighbours[blank]) {
+                if (to >= 0 && to != previous) choices[count++] = to;
+            }
+            int to = choices[random() % count];
+            state = Puzzle::move_blank(state, blank, to);
+            previous = blank;
+            blank = to;
+        }
+
+        // The walk's length bounds the depth, so a walk into a full band needs no solving.
+        int band = min(length, max_depth) / BENCH_BAND;
+        bool room = false;
+        for (int b = 0; b <= band; ++b) {
+            room = room || static_cast<int>(by_band[b].size()) < bench.per_bucket;
+        }
+        if (!room) continue;
+
+        int depth = solve(state, exact, context).depth;
+        if (depth == 0 || depth > max_depth) continue;
+        vector<BenchBoard<Puzzle>> &boards = by_band[depth / BENCH_BAND];
+        if (static_cast<int>(boards.size()) < bench.per_bucket
+            && none_of(boards.begin(), boards.end(), [&](const BenchBoard<Puzzle> &b) { return b.state == state; })) {
+            boards.push_back(BenchBoard<Puzzle>{state, depth});
+            missing--;
+        }
+    }
+
+    vector<BenchBoard<Puzzle>> corpus;
+    for (const vector<BenchBoard<Puzzle>> &boards : by_band) {
+        corpus.insert(corpus.end(), boards.begin(), boards.end());
+    }
+    return corpus;
+}
+
+// One engine and heuristic over one band of the corpus.
+struct BenchRow {
+    string engine, heuristic;
+    int band = 0; // Depths band * BENCH_BAND up to band * BENCH_BAND + BENCH_BAND - 1
+    int boards = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0; // Seconds per solve
+    double mean_expanded = 0;
+    double nodes_per_second = 0; // Nodes generated over the time spent solving
+    long peak_kb = 0;            // The peak resident size while the row ran
+    int wrong = 0;               // Solves that were not optimal
+};
+
+// The q-th quantile of sorted latencies, by nearest rank.
+double percentile(const vector<double> &sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(ceil(q * sorted.size()));
+    return sorted[min(sorted.size(), max<size_t>(rank, 1)) - 1];
+}
+
+// Restart the peak resident size from the current one, so the next reading covers only
+// what ran since. Linux only; false if the kernel would not reset it.
+bool reset_peak_resident() {
+    ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5" << flush;
+    return static_cast<bool>(clear_refs);
+}
+
+// The peak resident size in KB since the last reset_peak_resident(), or the process's
+// lifetime peak where /proc has no VmHWM.
+long peak_resident_kb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return atol(line.c_str() + 6);
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Whether `name` is on a comma-separated list; an empty list holds everything.
+bool bench_selected(const string &list, const string &name) {
+    if (list.empty()) return true;
+    return (',' + list + ',').find(',' + name + ',') != string::npos;
+}
+
+template <class Puzzle>
+vector<BenchRow> run_bench(const vector<BenchBoard<Puzzle>> &corpus, const SearchOptions &base,
+                           const BenchOptions &bench) {
+    struct Engine {
+        const char *name;
+        SearchEngine engine;
+    };
+    struct Heuristic {
+        const char *name;
+        HeuristicKind heuristic;
+    };
+    vector<Engine> engines = {{"astar", SearchEngine::AStar}, {"idastar", SearchEngine::IDAStar},
+                              {"hdastar", SearchEngine::HDAStar}, {"mm", SearchEngine::Bidirectional},
+                              {"sma", SearchEngine::MemoryBounded}};
+    vector<Heuristic> heuristics = {{"misplaced", HeuristicKind::MisplacedTiles},
+                                    {"manhattan", HeuristicKind::ManhattanCorner}};
+    if (Puzzle::DIMENSION == 3) {
+        engines.push_back({"oracle", SearchEngine::Oracle});
+        heuristics.push_back({"pdb", HeuristicKind::PatternDatabase});
+    }
+
+    vector<BenchRow> rows;
+    SearchContext<Puzzle> context;
+    for (const Engine &engine : engines) {
+        if (!bench_selected(bench.engines, engine.name)) continue;
+        for (const Heuristic &heuristic : heuristics) {
+            if (!bench_selected(bench.heuristics, heuristic.name)) continue;
+            // The oracle does not search, so the heuristic makes no difference to it.
+            if (engine.engine == SearchEngine::Oracle && heuristic.heuristic != HeuristicKind::ManhattanCorner) continue;
+
+            SearchOptions options = base;
+            options.engine = engine.engine;
+            options.heuristic = heuristic.heuristic;
+            for (size_t first = 0; first < corpus.size();) {
+                BenchRow row;
+                row.engine = engine.name;
+                row.heuristic = engine.engine == SearchEngine::Oracle ? "-" : heuristic.name;
+                row.band = corpus[first].depth / BENCH_BAND;
+                vector<double> latencies;
+                double total_time = 0, total_generated = 0, total_expanded = 0;
+                size_t last = first;
+                reset_peak_resident();
+                for (; last < corpus.size() && corpus[last].depth / BENCH_BAND == row.band; ++last) {
+                    for (int i = 0; i < bench.warmup; ++i) {
+                        solve(corpus[last].state, options, context);
+                    }
+                    for (int i = 0; i < bench.repeat; ++i) {
+                        auto start_time = chrono::steady_clock::now();
+                        SearchResult<Puzzle> result = solve(corpus[last].state, options, context);
+                        chrono::duration<double> elapsed_time = chrono::steady_clock::now() - start_time;
+                        latencies.push_back(elapsed_time.count());
+                        total_time += elapsed_time.count();
+                        total_generated += result.num_nodes_generated;
+                        total_expanded += result.num_nodes_expanded;
+                        row.wrong += result.depth != corpus[last].depth;
+                    }
+                }
+                sort(latencies.begin(), latencies.end());
+                row.boards = last - first;
+                row.p50 = percentile(latencies, 0.50);
+                row.p90 = percentile(latencies, 0.90);
+                row.p99 = percentile(latencies, 0.99);
+                row.max = latencies.empty() ? 0 : latencies.back();
+                row.mean_expanded = latencies.empty() ? 0 : total_expanded / latencies.size();
+                row.nodes_per_second = total_time > 0 ? total_generated / total_time : 0;
+                row.peak_kb = peak_resident_kb();
+                rows.push_back(row);
+                first = last;
+            }
+        }
+    }
+    return rows;
+}
+
+void print_bench_rows(const vector<BenchRow> &rows) {
+    cout << left << setw(8) << "engine" << setw(10) << "heuristic" << right << setw(7) << "depths" << setw(7)
+         << "boards" << setw(11) << "p50 ms" << setw(11) << "p90 ms" << setw(11) << "p99 ms" << setw(11) << "max ms"
+         << setw(12) << "expanded" << setw(13) << "nodes/s" << setw(11) << "peak KB" << '\n';
+    for (const BenchRow &row : rows) {
+        string depths = to_string(row.band * BENCH_BAND) + "-" + to_string(row.band * BENCH_BAND + BENCH_BAND - 1);
+        cout << left << setw(8) << row.engine << setw(10) << row.heuristic << right << setw(7) << depths << setw(7)
+             << row.boards << fixed << setprecision(3) << setw(11) << row.p50 * 1e3 << setw(11) << row.p90 * 1e3
+             << setw(11) << row.p99 * 1e3 << setw(11) << row.max * 1e3 << setprecision(1) << setw(12)
+             << row.mean_expanded << setprecision(0) << setw(13) << row.nodes_per_second << setw(11) << row.peak_kb;
+        cout.unsetf(ios::floatfield);
+        cout << setprecision(6);
+        if (row.wrong > 0) {
+            cout << "  " << row.wrong << " NOT OPTIMAL";
+        }
+        cout << '\n';
+    }
+    cout.flush();
+}
+
+// A baseline is one line per row: engine, heuristic, band, boards, p50 seconds and mean
+// nodes expanded. The header names the corpus so a baseline is only compared with runs
+// over the same boards.
+string bench_corpus_name(int dimension, const BenchOptions &bench) {
+    return "size=" + to_string(dimension) + " seed=" + to_string(bench.seed) + " per-bucket="
+           + to_string(bench.per_bucket);
+}
+
+bool save_bench_baseline(const string &path, const string &corpus_name, const vector<BenchRow> &rows) {
+    ofstream out(path);
+    out << "# bench baseline " << corpus_name << '\n';
+    for (const BenchRow &row : rows) {
+        out << row.engine << ' ' << row.heuristic << ' ' << row.band << ' ' << row.boards << ' ' << row.p50 << ' '
+            << row.mean_expanded << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+// The number of rows that got slower (p50) or expanded more nodes than the baseline
+// allows, or -1 if the baseline is unreadable or was taken over another corpus.
+int compare_bench_baseline(const string &path, const string &corpus_name, const vector<BenchRow> &rows,
+                           double tolerance) {
+    ifstream in(path);
+    string header;
+    if (!getline(in, header) || header != "# bench baseline " + corpus_name) {
+        return -1;
+    }
+    int regressions = 0;
+    BenchRow old;
+    while (in >> old.engine >> old.heuristic >> old.band >> old.boards >> old.p50 >> old.mean_expanded) {
+        for (const BenchRow &row : rows) {
+            if (row.engine != old.engine || row.heuristic != old.heuristic || row.band != old.band) continue;
+            bool slower = row.p50 > old.p50 + max(old.p50 * tolerance, BENCH_NOISE_FLOOR);
+            bool bigger = row.mean_expanded > old.mean_expanded * (1 + tolerance);
+            if (slower || bigger) {
+                cout << "REGRESSION " << row.engine << ' ' << row.heuristic << " depths " << row.band * BENCH_BAND
+                     << "-" << row.band * BENCH_BAND + BENCH_BAND - 1 << ": p50 " << old.p50 * 1e3 << " -> "
+                     << row.p50 * 1e3 << " ms, expanded " << old.mean_expanded << " -> " << row.mean_expanded
+                     << '\n';
+                regressions++;
+            }
+        }
+    }
+    return regressions;
+}
+
+// Parses tile groups written as digit runs separated by commas, e.g. "1234,5678".
+bool parse_tile_groups(const string &text, vector<vector<int>> &groups) {
+    groups.assign(1, vector<int>());
+    unsigned seen = 0;
+    for (char c : text) {
+        if (c == ',') {
+            groups.emplace_back();
+            continue;
+        }
+        int tile = c - '0';
+        if (tile < 1 || tile >= EightPuzzle::CELLS || (seen & (1u << tile))) {
+            return false;
+        }
+        seen |= 1u << tile;
+        groups.back().push_back(tile);
+    }
+    for (vector<int> &group : groups) {
+        if (group.empty()) return false;
+        sort(group.begin(), group.end());
+    }
+    return true;
+}
+
+// The board to solve when not in batch mode: one of the two sample 8-puzzle boards, or
+// a board typed in for the larger puzzles. The prompt goes to stderr, so standard output
+// holds nothing but the answer in whichever --output format was asked for.
+template <class Puzzle>
+bool read_initial_state(typename Puzzle::State &initial_state) {
+    if constexpr (is_same<Puzzle, EightPuzzle>::value) {
+        vector<int> initial_state1 = {2, 8, 3, 1, 6, 4, 0, 7, 5};
+        vector<int> initial_state2 = {2, 1, 6, 4, 0, 8, 7, 5, 3};
+
+        int choice;
+        cerr << "Choose the initial state (1 or 2):" << endl;
+        cerr << "1. Initial state 1" << endl;
+        cerr << "2. Initial state 2" << endl;
+        cin >> choice;
+
+        initial_state = EightPuzzle::pack((choice == 1) ? initial_state1 : initial_state2);
+        return true;
+    } else {
+        cerr << "Enter the " << Puzzle::DIMENSION << "x" << Puzzle::DIMENSION
+             << " board in row order, tiles separated by spaces (0 for the blank):" << endl;
+        string line;
+        getline(cin, line);
+        return parse_board<Puzzle>(line, initial_state);
+    }
+}
+
+// --verify-heuristic: checks the chosen heuristic against exact distances and fails
+// unless it is admissible and its incremental updates are right.
+template <class Puzzle>
+int verify(const SearchOptions &options) {
+    // The whole 8-puzzle space, and on bigger boards every board within a dozen or so moves
+    const size_t max_boards = 1 << 20;
+    HeuristicReport report = verify_heuristic<Puzzle>(options, max_boards);
+    print_heuristic_report(report);
+    return report.overestimates == 0 && report.update_mismatches == 0 ? 0 : 1;
+}
+
+template <class Puzzle>
+int benchmark(const SearchOptions &options, const BenchOptions &bench) {
+    vector<BenchBoard<Puzzle>> corpus = make_bench_corpus<Puzzle>(bench);
+    string corpus_name = bench_corpus_name(Puzzle::DIMENSION, bench);
+    cout << "Corpus " << corpus_name << ": " << corpus.size() << " boards, " << bench.warmup << " warmup and "
+         << bench.repeat << " timed solves each" << endl;
+    vector<BenchRow> rows = run_bench(corpus, options, bench);
+    print_bench_rows(rows);
+
+    int status = 0;
+    for (const BenchRow &row : rows) {
+        if (row.wrong > 0) status = 1;
+    }
+    if (!bench.baseline_path.empty()) {
+        int regressions = compare_bench_baseline(bench.baseline_path, corpus_name, rows, bench.tolerance);
+        if (regressions < 0) {
+            cerr << "No baseline for " << corpus_name << " in " << bench.baseline_path << endl;
+            status = 1;
+        } else {
+            cout << regressions << " regressions against " << bench.baseline_path << endl;
+            if (regressions > 0) status = 1;
+        }
+    }
+    if (!bench.save_path.empty() && !save_bench_baseline(bench.save_path, corpus_name, rows)) {
+        cerr << "Could not write baseline to " << bench.save_path << endl;
+        status = 1;
+    }
+    return status;
+}
+
+// --to-binary=FILE turns the text boards of --batch (or standard input) into a board
+// file; --to-text=FILE prints a board or result file as text.
+template <class Puzzle>
+int convert(const string &batch_path, const string &board_file_path, const string &text_path) {
+    if (text_path.empty()) {
+        if (batch_path.empty() || batch_path == "-") {
+            return convert_to_board_file<Puzzle>(cin, board_file_path);
+        }
+        ifstream in(batch_path);
+        if (!in) {
+            cerr << "Could not open " << batch_path << endl;
+            return 1;
+        }
+        return convert_to_board_file<Puzzle>(in, board_file_path);
+    }
+    return convert_to_text<Puzzle>(text_path, cout);
+}
+
+template <class Puzzle>
+int run(const SearchOptions &options, bool batch, const string &batch_path, int num_threads, OutputFormat format,
+        const string &trace_path, int trace_every) {
+    if (batch) {
+        if (batch_path.empty() || batch_path == "-") {
+            solve_batch<Puzzle>(cin, cout, options, num_threads, format);
+        } else if (MappedFile file(batch_path); file.starts_with(BOARD_FILE_MAGIC)) {
+            file.advise_sequential();
+            size_t count = 0;
+            const typename Puzzle::State *boards = board_file_boards<Puzzle>(file, count);
+            if (!boards) {
+                cerr << batch_path << " is not a complete board file for " << Puzzle::DIMENSION << "x"
+                     << Puzzle::DIMENSION << " boards" << endl;
+                return 1;
+            }
+            solve_board_file<Puzzle>(boards, count, cout, options, num_threads, format);
+        } else {
+            ifstream in(batch_path);
+            if (!in) {
+                cerr << "Could not open " << batch_path << endl;
+                return 1;
+            }
+            solve_batch<Puzzle>(in, cout, options, num_threads, format);
+        }
+        return 0;
+    }
+
+    typename Puzzle::State initial_state;
+    if (!read_initial_state<Puzzle>(initial_state)) {
+        cerr << "Invalid board" << endl;
+        return 1;
+    }
+    bool solvable = is_solvable<Puzzle>(initial_state);
+    if (!solvable && format == OutputFormat::Text) {
+        cout << "No solution exists: the goal cannot be reached from this board." << endl;
+        return 0;
+    }
+
+    SearchTrace trace;
+    if (!trace_path.empty()) {
+        if (!trace.open(trace_path, Puzzle::DIMENSION, trace_every)) {
+            cerr << "Could not write trace to " << trace_path << endl;
+            return 1;
+        }
+        active_trace = &trace;
+    }
+
+    SearchContext<Puzzle> context;
+    SearchResult<Puzzle> result;
+    if (solvable) {
+        result = solve(initial_state, options, context);
+    }
+    active_trace = nullptr;
+
+    if (format != OutputFormat::Text) {
+        ResultStatus status = !solvable ? ResultStatus::Unsolvable
+                              : result.path.empty() ? ResultStatus::Unsolved : ResultStatus::Solved;
+        if (format == OutputFormat::Binary) {
+            BinaryResultWriter<Puzzle>(cout).write(initial_state, status, result);
+        } else {
+            ResultSink<Puzzle>(cout, format).write(board_to_string<Puzzle>(initial_state), status, result);
+        }
+    } else if (!result.path.empty()) {
+        cout << "Solution found in " << result.path.size() - 1 << " steps:" << '\n';
+        for (typename Puzzle::State state : result.path) {
+            print_state<Puzzle>(state);
+        }
+
+        cout << "Execution Time: " << result.execution_time << " seconds" << '\n';
+        cout << "Number of Nodes Generated: " << result.num_nodes_generated << '\n';
+        cout << "Number of Nodes Expanded: " << result.num_nodes_expanded << '\n';
+        cout << "Depth of the Tree: " << result.depth << '\n';
+        cout << "Effective Branching Factor: " << result.effective_branching_factor << '\n';
+        cout << "Total Path: " << result.path.size() << '\n';
+        if (options.engine == SearchEngine::MemoryBounded) {
+            cout << "Nodes forgotten / regenerated to stay within " << (options.memory_budget >> 10) << " KB: "
+                 << result.counters.forgotten << " / " << result.counters.regenerated << '\n';
+        }
+#if SEARCH_COUNTERS
+        const SearchCounters &counters = result.counters;
+        cout << "Open list pushes / pops: " << counters.open_pushes << " / " << counters.open_pops << '\n';
+        cout << "Duplicates on OPEN / CLOSED: " << counters.open_duplicates << " / " << counters.closed_duplicates
+             << '\n';
+        cout << "Reopenings: " << counters.reopenings << ", stale pops: " << counters.stale_pops << '\n';
+        cout << "Heuristic updates: " << counters.heuristic_updates << " in " << counters.heuristic_seconds
+             << " seconds" << '\n';
+        cout << "Allocations: " << counters.allocations << '\n';
+        cout << "Peak OPEN / CLOSED: " << counters.peak_open << " / " << counters.peak_closed << '\n';
+#endif
+        cout.flush();
+    } else if (options.engine == SearchEngine::MemoryBounded) {
+        cout << "No solution found within " << (options.memory_budget >> 10) << " KB." << endl;
+    } else {
+        cout << "No solution found." << endl;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    SearchOptions options;
+    string pattern_database_path;
+    string oracle_path;
+    vector<vector<int>> tile_groups = {{1, 2, 3, 4}, {5, 6, 7, 8}};
+    int board_dimension = 3;
+    bool batch = false;
+    bool verify_only = false;
+    bool bench_only = false;
+    bool serve_only = false;
+    string socket_path;
+    size_t cache_capacity = 1 << 20;
+    BenchOptions bench;
+    string batch_path;
+    OutputFormat format = OutputFormat::Text;
+    string trace_path;
+    int trace_every = 1;
+    string board_file_path;
+    string text_path;
+    int num_threads = max(1u, thread::hardware_concurrency());
+    options.threads = num_threads;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--size=3") {
+            board_dimension = 3;
+        } else if (arg == "--size=4") {
+            board_dimension = 4;
+        } else if (arg == "--size=5") {
+            board_dimension = 5;
+        } else if (arg == "--verify-heuristic") {
+            verify_only = true;
+        } else if (arg == "--serve") {
+            serve_only = true;
+        } else if (arg.rfind("--socket=", 0) == 0) {
+            serve_only = true;
+            socket_path = arg.substr(9);
+        } else if (arg.rfind("--cache=", 0) == 0) {
+            cache_capacity = max(1L, atol(arg.c_str() + 8));
+        } else if (arg == "--bench") {
+            bench_only = true;
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            bench.seed = strtoull(arg.c_str() + 7, nullptr, 10);
+        } else if (arg.rfind("--bench-per-bucket=", 0) == 0) {
+            bench.per_bucket = max(1, atoi(arg.c_str() + 19));
+        } else if (arg.rfind("--warmup=", 0) == 0) {
+            bench.warmup = max(0, atoi(arg.c_str() + 9));
+        } else if (arg.rfind("--repeat=", 0) == 0) {
+            bench.repeat = max(1, atoi(arg.c_str() + 9));
+        } else if (arg.rfind("--tolerance=", 0) == 0) {
+            bench.tolerance = atof(arg.c_str() + 12) / 100;
+        } else if (arg.rfind("--bench-engines=", 0) == 0) {
+            bench.engines = arg.substr(16);
+        } else if (arg.rfind("--bench-heuristics=", 0) == 0) {
+            bench.heuristics = arg.substr(19);
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            bench.baseline_path = arg.substr(11);
+        } else if (arg.rfind("--save-baseline=", 0) == 0) {
+            bench.save_path = arg.substr(16);
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            batch = true;
+            batch_path = arg.substr(8);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            num_threads = max(1, atoi(arg.c_str() + 10));
+            options.threads = num_threads;
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            trace_path = arg.substr(8);
+        } else if (arg.rfind("--trace-every=", 0) == 0) {
+            trace_every = max(1, atoi(arg.c_str() + 14));
+        } else if (arg == "--simd=off") {
+            simd_level = SimdLevel::Scalar;
+        } else if (arg == "--simd=auto") {
+            simd_level = detect_simd_level();
+        } else if (arg == "--output=text") {
+            format = OutputFormat::Text;
+        } else if (arg == "--output=csv") {
+            format = OutputFormat::Csv;
+        } else if (arg == "--output=json") {
+            format = OutputFormat::Json;
+        } else if (arg == "--output=path") {
+            format = OutputFormat::Path;
+        } else if (arg == "--output=binary") {
+            format = OutputFormat::Binary;
+        } else if (arg.rfind("--to-binary=", 0) == 0) {
+            board_file_path = arg.substr(12);
+        } else if (arg.rfind("--to-text=", 0) == 0) {
+            text_path = arg.substr(10);
+        } else if (arg == "--output=none") {
+            format = OutputFormat::Silent;
+        } else if (arg == "--engine=astar") {
+            options.engine = SearchEngine::AStar;
+        } else if (arg == "--engine=idastar") {
+            options.engine = SearchEngine::IDAStar;
+        } else if (arg == "--engine=hdastar") {
+            options.engine = SearchEngine::HDAStar;
+        } else if (arg == "--engine=mm") {
+            options.engine = SearchEngine::Bidirectional;
+        } else if (arg == "--engine=sma") {
+            options.engine = SearchEngine::MemoryBounded;
+        } else if (arg.rfind("--memory=", 0) == 0) {
+            options.engine = SearchEngine::MemoryBounded;
+            options.memory_budget = static_cast<size_t>(max(0.0, atof(arg.c_str() + 9)) * (1 << 20));
+        } else if (arg == "--engine=oracle") {
+            options.engine = SearchEngine::Oracle;
+        } else if (arg.rfind("--oracle=", 0) == 0) {
+            options.engine = SearchEngine::Oracle;
+            oracle_path = arg.substr(9);
+        } else if (arg == "--heuristic=manhattan") {
+            options.heuristic = HeuristicKind::ManhattanCorner;
+        } else if (arg == "--heuristic=misplaced") {
+            options.heuristic = HeuristicKind::MisplacedTiles;
+        } else if (arg == "--heuristic=pdb") {
+            options.heuristic = HeuristicKind::PatternDatabase;
+        } else if (arg.rfind("--pdb=", 0) == 0) {
+            options.heuristic = HeuristicKind::PatternDatabase;
+            pattern_database_path = arg.substr(6);
+        } else if (arg.rfind("--pdb-groups=", 0) == 0) {
+            if (!parse_tile_groups(arg.substr(13), tile_groups)) {
+                cerr << "Invalid tile groups: " << arg.substr(13) << endl;
+                return 1;
+            }
+        } else if (arg == "--closed=hash") {
+            options.closed_list = ClosedListKind::HashTable;
+        } else if (arg == "--closed=rank") {
+            options.closed_list = ClosedListKind::RankTable;
+        } else if (arg == "--open=heap") {
+            options.open_list = OpenListKind::BinaryHeap;
+        } else if (arg == "--open=buckets") {
+            options.open_list = OpenListKind::Buckets;
+        } else if (arg == "--tie=high-g") {
+            options.tie_break = TieBreak::HighG;
+        } else if (arg == "--tie=low-g") {
+            options.tie_break = TieBreak::LowG;
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (!trace_path.empty() && !SEARCH_COUNTERS) {
+        cerr << "--trace needs a build with -DSEARCH_COUNTERS=1" << endl;
+        return 1;
+    }
+    if (serve_only && format == OutputFormat::Binary) {
+        cerr << "--output=binary is for batches; --serve answers in text" << endl;
+        return 1;
+    }
+
+    if (!board_file_path.empty() || !text_path.empty()) {
+        return board_dimension == 3   ? convert<EightPuzzle>(batch_path, board_file_path, text_path)
+               : board_dimension == 4 ? convert<FifteenPuzzle>(batch_path, board_file_path, text_path)
+                                      : convert<TwentyFourPuzzle>(batch_path, board_file_path, text_path);
+    }
+
+    if (board_dimension != 3 && bench_only) {
+        return board_dimension == 4 ? benchmark<FifteenPuzzle>(options, bench)
+                                    : benchmark<TwentyFourPuzzle>(options, bench);
+    }
+    if (board_dimension != 3) {
+        if (options.heuristic == HeuristicKind::PatternDatabase) {
+            cerr << "Pattern databases are only available for the 3x3 board" << endl;
+            return 1;
+        }
+        if (options.engine == SearchEngine::Oracle) {
+            cerr << "The distance oracle is only available for the 3x3 board" << endl;
+            return 1;
+        }
+        if (serve_only) {
+            return board_dimension == 4 ? serve<FifteenPuzzle>(options, socket_path, cache_capacity, format)
+                                        : serve<TwentyFourPuzzle>(options, socket_path, cache_capacity, format);
+        }
+        if (board_dimension == 4) {
+            return verify_only ? verify<FifteenPuzzle>(options)
+                               : run<FifteenPuzzle>(options, batch, batch_path, num_threads, format, trace_path, trace_every);
+        }
+        return verify_only ? verify<TwentyFourPuzzle>(options)
+                           : run<TwentyFourPuzzle>(options, batch, batch_path, num_threads, format, trace_path, trace_every);
+    }
+
+    PatternDatabase pattern_database;
+    if (options.heuristic == HeuristicKind::PatternDatabase || (bench_only && bench_selected(bench.heuristics, "pdb"))) {
+        bool loaded = !pattern_database_path.empty() && pattern_database.load(pattern_database_path)
+                      && pattern_database.matches(EightPuzzle::goal, tile_groups);
+        if (!loaded) {
+            pattern_database.build(EightPuzzle::goal, tile_groups);
+            if (!pattern_database_path.empty() && !pattern_database.save(pattern_database_path)) {
+                cerr << "Could not write pattern database to " << pattern_database_path << endl;
+            }
+        }
+        options.pattern_database = &pattern_database;
+    }
+
+    DistanceOracle oracle;
+    if (options.engine == SearchEngine::Oracle || (bench_only && bench_selected(bench.engines, "oracle"))) {
+        bool loaded = !oracle_path.empty() && oracle.load(oracle_path) && oracle.matches(EightPuzzle::goal);
+        if (!loaded) {
+            oracle.build(EightPuzzle::goal);
+            if (!oracle_path.empty() && !oracle.save(oracle_path)) {
+                cerr << "Could not write distance oracle to " << oracle_path << endl;
+            }
+        }
+        options.oracle = &oracle;
+    }
+
+    if (bench_only) {
+        return benchmark<EightPuzzle>(options, bench);
+    }
+    if (serve_only) {
+        return serve<EightPuzzle>(options, socket_path, cache_capacity, format);
+    }
+    return verify_only ? verify<EightPuzzle>(options) : run<EightPuzzle>(options, batch, batch_path, num_threads, format, trace_path, trace_every);
+}